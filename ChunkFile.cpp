@@ -0,0 +1,138 @@
+#include "ChunkFile.hpp"
+
+ChunkFile::ChunkFile(std::string const &filename_) : filename(filename_), data(filename_), file(data.stream) {
+	file_size = data.size;
+
+	//(loose) check that a table of contents entry fits in the file; read_data checks the actual header:
+	auto check_extent = [&](Chunk const &chunk) {
+		if (chunk.offset > file_size || 8 + chunk.stored_size > file_size - chunk.offset) {
+			throw std::runtime_error("Chunk '" + chunk.magic + "' extends past the end of '" + filename + "'");
+		}
+	};
+
+	if (file.peek() == EOF) return; //empty file, no chunks
+
+	ChunkInfo first = read_chunk_header(file);
+	if (first.magic == "toc0") {
+		//index from the table of contents:
+		if (first.size % sizeof(ChunkTocEntry) != 0) {
+			throw std::runtime_error("Table of contents in '" + filename + "' has a partial entry");
+		}
+		std::vector< ChunkTocEntry > toc(size_t(first.size / sizeof(ChunkTocEntry)));
+		read_chunk_data(file, first, toc.data());
+		chunks.reserve(toc.size());
+		for (auto const &entry : toc) {
+			chunks.emplace_back();
+			Chunk &chunk = chunks.back();
+			chunk.magic = std::string(entry.magic, 4);
+			chunk.flags = entry.flags;
+			chunk.offset = entry.offset;
+			chunk.size = entry.size;
+			chunk.stored_size = entry.stored_size;
+			check_extent(chunk);
+		}
+	} else {
+		//index by skipping from header to header:
+		file.seekg(0, std::ios::beg);
+		uint64_t at = 0;
+		while (at < file_size) {
+			file.seekg(std::streamoff(at), std::ios::beg);
+			ChunkInfo info = read_chunk_header(file);
+			chunks.emplace_back();
+			Chunk &chunk = chunks.back();
+			chunk.magic = info.magic;
+			chunk.flags = info.flags;
+			chunk.offset = at;
+			chunk.size = info.size;
+			chunk.stored_size = info.stored_size;
+			//header size comes from the stream position, since small chunks may also use extended headers:
+			uint64_t data_begin = uint64_t(file.tellg());
+			if (info.stored_size > file_size - data_begin) {
+				throw std::runtime_error("Chunk '" + chunk.magic + "' extends past the end of '" + filename + "'");
+			}
+			at = data_begin + info.stored_size;
+		}
+	}
+}
+
+ChunkFile::Chunk const *ChunkFile::find(std::string const &magic) const {
+	for (auto const &chunk : chunks) {
+		if (chunk.magic == magic) return &chunk;
+	}
+	return nullptr;
+}
+
+ChunkInfo ChunkFile::seek_data(Chunk const &chunk) {
+	file.clear();
+	file.seekg(std::streamoff(chunk.offset), std::ios::beg);
+	ChunkInfo info = read_chunk_header(file);
+	if (info.magic != chunk.magic || info.size != chunk.size || info.stored_size != chunk.stored_size) {
+		throw std::runtime_error("Chunk '" + chunk.magic + "' in '" + filename + "' does not match its table of contents entry");
+	}
+	return info;
+}
+
+void ChunkFile::read_data(Chunk const &chunk, void *to) {
+	ChunkInfo info = seek_data(chunk);
+	read_chunk_data(file, info, to);
+}
+
+void ChunkFile::read_range(Chunk const &chunk, uint64_t begin, uint64_t size, void *to_) {
+	char *to = reinterpret_cast< char * >(to_);
+	if (begin > chunk.size || size > chunk.size - begin) {
+		throw std::runtime_error("Range is outside of chunk '" + chunk.magic + "' in '" + filename + "'");
+	}
+	ChunkInfo info = seek_data(chunk);
+	uint64_t end = begin + size;
+
+	if (!(info.flags & ChunkFlagCompressed)) {
+		file.seekg(std::streamoff(begin), std::ios::cur);
+		if (!file.read(to, std::streamsize(size))) {
+			throw std::runtime_error("Failed to read chunk data.");
+		}
+		return;
+	}
+
+	//skip over blocks before the range, decode the ones that overlap it:
+	std::vector< char > stored;
+	std::vector< char > decoded;
+	uint64_t in = 0;
+	uint64_t out = 0;
+	while (out < end) {
+		uint32_t sizes[2];
+		if (info.stored_size - in < sizeof(sizes) || !file.read(reinterpret_cast< char * >(sizes), sizeof(sizes))) {
+			throw std::runtime_error("Truncated block header in chunk '" + info.magic + "'");
+		}
+		in += sizeof(sizes);
+		if (sizes[0] > ChunkBlockSize || sizes[1] > info.stored_size - in || sizes[0] > info.size - out) {
+			throw std::runtime_error("Block out of range in chunk '" + info.magic + "'");
+		}
+		if (out + sizes[0] <= begin) {
+			file.seekg(sizes[1], std::ios::cur);
+		} else {
+			stored.resize(sizes[1]);
+			if (!file.read(stored.data(), sizes[1])) {
+				throw std::runtime_error("Failed to read chunk data.");
+			}
+			char const *block = stored.data();
+			if (sizes[1] != sizes[0]) {
+				decoded.resize(sizes[0]);
+				lz4_block_decompress(stored.data(), sizes[1], decoded.data(), sizes[0]);
+				block = decoded.data();
+			}
+			uint64_t from = std::max(begin, out);
+			uint64_t until = std::min(end, out + sizes[0]);
+			std::memcpy(to + (from - begin), block + (from - out), size_t(until - from));
+		}
+		in += sizes[1];
+		out += sizes[0];
+	}
+}
+
+std::istream &ChunkFile::seek_after(Chunk const &chunk) {
+	file.clear();
+	file.seekg(std::streamoff(chunk.offset), std::ios::beg);
+	ChunkInfo info = read_chunk_header(file);
+	file.seekg(std::streamoff(info.stored_size), std::ios::cur);
+	return file;
+}
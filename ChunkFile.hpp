@@ -0,0 +1,88 @@
+#pragma once
+
+/*
+ * ChunkFile gives random access to the chunks of a chunk-based file
+ *  (the format written by write_chunk; see read_write_chunk.hpp).
+ *
+ * Files that start with a table of contents ('toc0') are indexed from it;
+ *  files in the plain sequential format are indexed by skipping from header
+ *  to header. Either way, only the chunks that are asked for get read.
+ *
+ */
+
+#include "read_write_chunk.hpp"
+#include "data_path.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct ChunkFile {
+	//open and index 'filename':
+	// throws if the file can't be opened or its headers / table of contents are malformed
+	explicit ChunkFile(std::string const &filename);
+
+	struct Chunk {
+		std::string magic;
+		uint32_t flags = 0;
+		uint64_t offset = 0; //offset of the chunk's header from the start of the file
+		uint64_t size = 0; //size of chunk data (once decoded)
+		uint64_t stored_size = 0; //size of data stored in the file
+	};
+	std::vector< Chunk > chunks; //in file order (not including 'toc0')
+
+	//first chunk with the given magic number (or nullptr if there isn't one):
+	Chunk const *find(std::string const &magic) const;
+
+	//read (and decode) a chunk's data into 'to', which must have room for chunk.size bytes:
+	// (e.g., 'to' may be a mapped buffer, to avoid a copy)
+	void read_data(Chunk const &chunk, void *to);
+
+	//read bytes [begin, begin+size) of a chunk's (decoded) data into 'to':
+	// (for compressed chunks, only the blocks that overlap the range are decoded)
+	void read_range(Chunk const &chunk, uint64_t begin, uint64_t size, void *to);
+
+	//position the stream at a chunk's header, read it, and check it against 'chunk':
+	ChunkInfo seek_data(Chunk const &chunk);
+
+	//read the first chunk with the given magic number as an array of T:
+	// throws if there is no such chunk
+	template< typename T >
+	void read(std::string const &magic, std::vector< T > *to);
+
+	//read a chunk's data in batches of (at most) 'batch' elements, handing each to callback(T const *elements, size_t count):
+	// (see read_chunk_batches in read_write_chunk.hpp)
+	template< typename T, typename F >
+	void read_batches(Chunk const &chunk, size_t batch, F const &callback);
+
+	//position the stream just after 'chunk' and return it (for code that reads the following chunks sequentially):
+	std::istream &seek_after(Chunk const &chunk);
+
+	std::string filename;
+	DataFile data; //(data.mapped points to the whole file if it is in memory already)
+	std::istream &file; //(data.stream)
+	uint64_t file_size = 0;
+};
+
+template< typename T >
+void ChunkFile::read(std::string const &magic, std::vector< T > *to_) {
+	assert(to_);
+	auto &to = *to_;
+
+	Chunk const *chunk = find(magic);
+	if (!chunk) {
+		throw std::runtime_error("File '" + filename + "' has no '" + magic + "' chunk");
+	}
+	if (chunk->size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+
+	to.resize(size_t(chunk->size / sizeof(T)));
+	read_data(*chunk, to.data());
+}
+
+template< typename T, typename F >
+void ChunkFile::read_batches(Chunk const &chunk, size_t batch, F const &callback) {
+	ChunkInfo info = seek_data(chunk);
+	read_chunk_batches< T >(file, info, batch, callback);
+}
@@ -0,0 +1,324 @@
+#include "CookedScene.hpp"
+
+#include <iostream>
+#include <cstring>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+CookedScene::CookedScene(std::string const &filename) {
+	ChunkFile file(filename);
+	load(file);
+}
+
+CookedScene::CookedScene(ChunkFile &file) {
+	load(file);
+}
+
+CookedScene::~CookedScene() {
+	#if !defined(_WIN32)
+	if (mapping) munmap(mapping, mapping_size);
+	#endif
+}
+
+void CookedScene::load(ChunkFile &file) {
+	ChunkFile::Chunk const *chunk = file.find("csn0");
+	if (!chunk) {
+		//plain scene file:
+		cook(file);
+		set_block(storage.data(), storage.size(), file.filename);
+		return;
+	}
+
+	if (!(chunk->flags & ChunkFlagCompressed) && file.data.mapped) {
+		//file is in the (mapped) data pack; use the block where it is:
+		file.seek_data(*chunk);
+		uint64_t data_offset = uint64_t(file.file.tellg());
+		if (data_offset % alignof(Transform) == 0) {
+			set_block(file.data.mapped + data_offset, chunk->size, file.filename);
+			return;
+		}
+	}
+
+	#if !defined(_WIN32)
+	if (!(chunk->flags & ChunkFlagCompressed) && !file.data.packed) {
+		//map the file and use the block where it is:
+		file.seek_data(*chunk);
+		uint64_t data_offset = uint64_t(file.file.tellg());
+		int fd = open(file.filename.c_str(), O_RDONLY);
+		//(mapping is page-aligned, so the block is aligned if its offset in the file is)
+		if (fd != -1 && data_offset % alignof(Transform) == 0) {
+			void *mapped = mmap(nullptr, size_t(file.file_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (mapped != MAP_FAILED) {
+				mapping = mapped;
+				mapping_size = size_t(file.file_size);
+				try {
+					set_block(reinterpret_cast< char const * >(mapping) + data_offset, chunk->size, file.filename);
+				} catch (...) {
+					//(the destructor won't run if the constructor throws)
+					munmap(mapping, mapping_size);
+					mapping = nullptr;
+					throw;
+				}
+				return;
+			}
+		} else if (fd != -1) {
+			close(fd);
+		}
+	}
+	#endif
+
+	//(compressed, or couldn't be mapped) read the block into memory:
+	storage.resize(size_t(chunk->size));
+	file.read_data(*chunk, storage.data());
+	set_block(storage.data(), storage.size(), file.filename);
+}
+
+void CookedScene::cook(ChunkFile &file) {
+	std::string const &filename = file.filename;
+
+	std::vector< char > str0;
+	file.read("str0", &str0);
+
+	struct HierarchyEntry {
+		uint32_t parent;
+		uint32_t name_begin;
+		uint32_t name_end;
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+	};
+	static_assert(sizeof(HierarchyEntry) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "HierarchyEntry is packed.");
+	std::vector< HierarchyEntry > hierarchy;
+	file.read("xfh0", &hierarchy);
+
+	struct MeshEntry {
+		uint32_t transform;
+		uint32_t name_begin;
+		uint32_t name_end;
+	};
+	static_assert(sizeof(MeshEntry) == 4 + 4 + 4, "MeshEntry is packed.");
+	std::vector< MeshEntry > meshes;
+	file.read("msh0", &meshes);
+
+	struct CameraEntry {
+		uint32_t transform;
+		char type[4]; //"pers" or "orth"
+		float data; //fov in degrees for 'pers', scale for 'orth'
+		float clip_near, clip_far;
+	};
+	static_assert(sizeof(CameraEntry) == 4 + 4 + 4 + 4 + 4, "CameraEntry is packed.");
+	std::vector< CameraEntry > camera_entries;
+	file.read("cam0", &camera_entries);
+
+	struct LightEntry {
+		uint32_t transform;
+		char type;
+		glm::u8vec3 color;
+		float energy;
+		float distance;
+		float fov;
+	};
+	static_assert(sizeof(LightEntry) == 4 + 1 + 3 + 4 + 4 + 4, "LightEntry is packed.");
+	std::vector< LightEntry > light_entries;
+	file.read("lmp0", &light_entries);
+
+	//--------------------------------
+	//convert entries to cooked form:
+
+	Contents contents;
+
+	std::vector< Transform > &cooked_transforms = contents.transforms;
+	cooked_transforms.reserve(hierarchy.size());
+	for (auto const &h : hierarchy) {
+		if (h.parent != -1U && h.parent >= cooked_transforms.size()) {
+			throw std::runtime_error("scene file '" + filename + "' did not contain transforms in topological-sort order.");
+		}
+		if (!(h.name_begin <= h.name_end && h.name_end <= str0.size())) {
+			throw std::runtime_error("scene file '" + filename + "' contains hierarchy entry with invalid name indices");
+		}
+		cooked_transforms.emplace_back();
+		Transform &t = cooked_transforms.back();
+		t.parent = h.parent;
+		t.name_begin = h.name_begin;
+		t.name_end = h.name_end;
+		t.position = h.position;
+		t.rotation = h.rotation;
+		t.scale = h.scale;
+	}
+
+	std::vector< Drawable > &cooked_drawables = contents.drawables;
+	cooked_drawables.reserve(meshes.size());
+	for (auto const &m : meshes) {
+		if (m.transform >= hierarchy.size()) {
+			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid transform index (" + std::to_string(m.transform) + ")");
+		}
+		if (!(m.name_begin <= m.name_end && m.name_end <= str0.size())) {
+			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid name indices");
+		}
+		cooked_drawables.emplace_back();
+		Drawable &d = cooked_drawables.back();
+		d.transform = m.transform;
+		d.name_begin = m.name_begin;
+		d.name_end = m.name_end;
+	}
+
+	std::vector< Camera > &cooked_cameras = contents.cameras;
+	for (auto const &c : camera_entries) {
+		if (c.transform >= hierarchy.size()) {
+			throw std::runtime_error("scene file '" + filename + "' contains camera entry with invalid transform index (" + std::to_string(c.transform) + ")");
+		}
+		if (std::string(c.type, 4) != "pers") {
+			std::cout << "Ignoring non-perspective camera (" + std::string(c.type, 4) + ") stored in file." << std::endl;
+			continue;
+		}
+		cooked_cameras.emplace_back();
+		Camera &camera = cooked_cameras.back();
+		camera.transform = c.transform;
+		camera.fovy = c.data / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
+		camera.near = c.clip_near;
+		//N.b. far plane is ignored because cameras use infinite perspective matrices.
+	}
+
+	std::vector< Light > &cooked_lights = contents.lights;
+	for (auto const &l : light_entries) {
+		if (l.transform >= hierarchy.size()) {
+			throw std::runtime_error("scene file '" + filename + "' contains lamp entry with invalid transform index (" + std::to_string(l.transform) + ")");
+		}
+		if (l.type == 'p') {
+			//good
+		} else if (l.type == 'h') {
+			//fine
+		} else if (l.type == 's') {
+			//okay
+		} else if (l.type == 'd') {
+			//sure
+		} else {
+			std::cout << "Ignoring unrecognized lamp type (" + std::string(&l.type, 1) + ") stored in file." << std::endl;
+			continue;
+		}
+		cooked_lights.emplace_back();
+		Light &light = cooked_lights.back();
+		light.transform = l.transform;
+		light.type = l.type;
+		light.energy = glm::vec3(l.color) / 255.0f * l.energy;
+		light.spot_fov = l.fov / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
+	}
+
+	contents.names.swap(str0);
+	storage = make_block(contents);
+}
+
+CookedScene::Contents CookedScene::contents() const {
+	Contents contents;
+	contents.names.assign(names.begin(), names.end());
+	contents.transforms.assign(transforms.begin(), transforms.end());
+	contents.drawables.assign(drawables.begin(), drawables.end());
+	contents.cameras.assign(cameras.begin(), cameras.end());
+	contents.lights.assign(lights.begin(), lights.end());
+	contents.buffer_names.assign(buffer_names.begin(), buffer_names.end());
+	contents.buffers.assign(buffers.begin(), buffers.end());
+	contents.mesh_refs.assign(mesh_refs.begin(), mesh_refs.end());
+	return contents;
+}
+
+std::vector< char > CookedScene::make_block(Contents const &contents) {
+	Header header;
+	uint64_t size = sizeof(Header);
+	auto place = [&size](Section *section, size_t count, size_t element_size) {
+		size = (size + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+		section->offset = size;
+		section->count = count;
+		size += count * element_size;
+	};
+	place(&header.names, contents.names.size(), sizeof(char));
+	place(&header.transforms, contents.transforms.size(), sizeof(Transform));
+	place(&header.drawables, contents.drawables.size(), sizeof(Drawable));
+	place(&header.cameras, contents.cameras.size(), sizeof(Camera));
+	place(&header.lights, contents.lights.size(), sizeof(Light));
+	place(&header.buffer_names, contents.buffer_names.size(), sizeof(char));
+	place(&header.buffers, contents.buffers.size(), sizeof(Buffer));
+	place(&header.mesh_refs, contents.mesh_refs.size(), sizeof(MeshRef));
+
+	std::vector< char > block(size_t(size), 0);
+	auto copy = [&block](Section const &section, void const *data, size_t element_size) {
+		if (section.count) std::memcpy(block.data() + section.offset, data, size_t(section.count) * element_size);
+	};
+	std::memcpy(block.data(), &header, sizeof(Header));
+	copy(header.names, contents.names.data(), sizeof(char));
+	copy(header.transforms, contents.transforms.data(), sizeof(Transform));
+	copy(header.drawables, contents.drawables.data(), sizeof(Drawable));
+	copy(header.cameras, contents.cameras.data(), sizeof(Camera));
+	copy(header.lights, contents.lights.data(), sizeof(Light));
+	copy(header.buffer_names, contents.buffer_names.data(), sizeof(char));
+	copy(header.buffers, contents.buffers.data(), sizeof(Buffer));
+	copy(header.mesh_refs, contents.mesh_refs.data(), sizeof(MeshRef));
+	return block;
+}
+
+void CookedScene::set_block(char const *block_, uint64_t block_size_, std::string const &filename) {
+	block = block_;
+	block_size = block_size_;
+
+	auto fail = [&filename](std::string const &what) {
+		throw std::runtime_error("cooked scene in '" + filename + "' " + what);
+	};
+
+	if (block_size < sizeof(Header)) fail("is too small to have a header");
+	Header header;
+	std::memcpy(&header, block, sizeof(Header));
+	if (header.version != Version) fail("has unsupported version " + std::to_string(header.version));
+
+	//point an Array at a section, after checking that it is inside the block and aligned for its elements:
+	auto find = [&](auto *array, Section const &section, char const *what) {
+		typedef typename std::remove_reference< decltype(*array->data) >::type T;
+		if (section.offset > block_size || section.count > (block_size - section.offset) / sizeof(T)) {
+			fail(std::string("has out-of-range ") + what + " section");
+		}
+		if (reinterpret_cast< uintptr_t >(block + section.offset) % alignof(T) != 0) {
+			fail(std::string("has misaligned ") + what + " section");
+		}
+		array->data = reinterpret_cast< T const * >(block + section.offset);
+		array->size = size_t(section.count);
+	};
+	find(&names, header.names, "names");
+	find(&transforms, header.transforms, "transforms");
+	find(&drawables, header.drawables, "drawables");
+	find(&cameras, header.cameras, "cameras");
+	find(&lights, header.lights, "lights");
+	find(&buffer_names, header.buffer_names, "buffer names");
+	find(&buffers, header.buffers, "buffers");
+	find(&mesh_refs, header.mesh_refs, "mesh references");
+
+	//check indices, so code using the block doesn't need to:
+	auto check_name = [&](uint32_t begin, uint32_t end, char const *what) {
+		if (!(begin <= end && end <= names.size)) fail(std::string("contains ") + what + " with invalid name indices");
+	};
+	for (size_t i = 0; i < transforms.size; ++i) {
+		if (transforms[i].parent != -1U && transforms[i].parent >= i) fail("did not contain transforms in topological-sort order");
+		check_name(transforms[i].name_begin, transforms[i].name_end, "transform");
+	}
+	for (auto const &d : drawables) {
+		if (d.transform >= transforms.size) fail("contains drawable with invalid transform index (" + std::to_string(d.transform) + ")");
+		check_name(d.name_begin, d.name_end, "drawable");
+	}
+	for (auto const &c : cameras) {
+		if (c.transform >= transforms.size) fail("contains camera with invalid transform index (" + std::to_string(c.transform) + ")");
+	}
+	for (auto const &l : lights) {
+		if (l.transform >= transforms.size) fail("contains light with invalid transform index (" + std::to_string(l.transform) + ")");
+		if (l.type != 'p' && l.type != 'h' && l.type != 's' && l.type != 'd') fail("contains light with unknown type");
+	}
+	for (auto const &b : buffers) {
+		if (!(b.name_begin <= b.name_end && b.name_end <= buffer_names.size)) fail("contains buffer with invalid name indices");
+	}
+	if (mesh_refs.size != 0 && mesh_refs.size != drawables.size) fail("has mesh references that don't match its drawables");
+	for (auto const &r : mesh_refs) {
+		if (r.buffer != -1U && r.buffer >= buffers.size) fail("contains mesh reference with invalid buffer index (" + std::to_string(r.buffer) + ")");
+	}
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+/*
+ * A CookedScene is a scene (see Scene.hpp) in a pointer-free layout:
+ *  one block of memory holding arrays of transforms, drawables, cameras, and
+ *  lights, which refer to each other (and to a shared array of names) by index.
+ *
+ * Since nothing in the block needs fixing up, a cooked scene stored in a file
+ *  (as the 'csn0' chunk written by 'asset-tool cook') can be mapped into memory
+ *  and read in place, or turned into Scene objects in one pass by Scene::load.
+ * Plain scene files (as written by export-scene.py) are cooked when loaded.
+ *
+ * 'asset-tool resolve' can also store, for each drawable, the mesh it uses
+ *  (file, vertex range, and bounds), so Scene::load can make drawables
+ *  without looking up mesh names.
+ *
+ */
+
+#include "ChunkFile.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CookedScene {
+	//the block holds a Header followed by its sections (each at an offset aligned to SectionAlignment):
+	enum : uint32_t { Version = 2, SectionAlignment = 16 };
+
+	struct Section {
+		uint64_t offset = 0; //from the start of the block
+		uint64_t count = 0; //number of elements
+	};
+	struct Header {
+		uint32_t version = Version;
+		uint32_t reserved = 0;
+		Section names; //char; the scene file's 'str0' chunk (so extra chunks can still refer to it)
+		Section transforms;
+		Section drawables;
+		Section cameras;
+		Section lights;
+		Section buffer_names; //char
+		Section buffers;
+		Section mesh_refs; //empty, or one per drawable
+	};
+	static_assert(sizeof(Header) == 4 + 4 + 8 * (8 + 8), "Header is packed.");
+
+	struct Transform {
+		uint32_t parent; //index of parent transform (always less than this transform's index), or -1U
+		uint32_t name_begin, name_end; //range in names
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+	};
+	static_assert(sizeof(Transform) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "Transform is packed.");
+
+	struct Drawable {
+		uint32_t transform; //index in transforms
+		uint32_t name_begin, name_end; //mesh name; range in names
+	};
+	static_assert(sizeof(Drawable) == 4 + 4 + 4, "Drawable is packed.");
+
+	struct Camera {
+		uint32_t transform; //index in transforms
+		float fovy; //radians
+		float near;
+	};
+	static_assert(sizeof(Camera) == 4 + 4 + 4, "Camera is packed.");
+
+	struct Light {
+		uint32_t transform; //index in transforms
+		char type; //one of the values of Scene::Light::Type
+		char padding[3];
+		glm::vec3 energy;
+		float spot_fov; //radians
+	};
+	static_assert(sizeof(Light) == 4 + 1 + 3 + 4*3 + 4, "Light is packed.");
+
+	//mesh files that drawables were resolved against by 'asset-tool resolve':
+	struct Buffer {
+		uint32_t name_begin, name_end; //file name (without directories); range in buffer_names
+		uint32_t mesh_count; //number of (uniquely named) meshes in the file, to catch references to an older version
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Buffer) == 4 + 4 + 4 + 4, "Buffer is packed.");
+
+	//the mesh a drawable uses, resolved ahead of time (so loading doesn't need to look up names):
+	struct MeshRef {
+		uint32_t buffer; //index in buffers, or -1U if the mesh wasn't found in any of them
+		uint32_t reserved;
+		uint64_t name_hash; //mesh_name_hash of the mesh's name (for MeshBuffer::lookup_id)
+		uint32_t start, count; //vertex range, relative to the first vertex in the mesh file
+		glm::vec3 min, max; //bounding box
+		glm::vec3 sphere_center; //bounding sphere
+		float sphere_radius;
+	};
+	static_assert(sizeof(MeshRef) == 4 + 4 + 8 + 4 + 4 + 4*3 + 4*3 + 4*3 + 4, "MeshRef is packed.");
+
+	//read-only view of a section of the block:
+	template< typename T >
+	struct Array {
+		T const *data = nullptr;
+		size_t size = 0;
+
+		T const *begin() const { return data; }
+		T const *end() const { return data + size; }
+		T const &operator[](size_t i) const { return data[i]; }
+	};
+
+	//use the cooked scene in 'file' (mapped into memory if it is stored uncompressed),
+	// or cook one from the plain scene chunks ('str0', 'xfh0', 'msh0', 'cam0', 'lmp0') in 'file':
+	// throws if the file is malformed
+	explicit CookedScene(ChunkFile &file);
+	explicit CookedScene(std::string const &filename);
+	~CookedScene();
+
+	//(may own a mapping, so can't be copied)
+	CookedScene(CookedScene const &) = delete;
+	CookedScene &operator=(CookedScene const &) = delete;
+
+	//sections of the block (indices in them have been checked):
+	Array< char > names;
+	Array< Transform > transforms;
+	Array< Drawable > drawables;
+	Array< Camera > cameras;
+	Array< Light > lights;
+	Array< char > buffer_names;
+	Array< Buffer > buffers;
+	Array< MeshRef > mesh_refs;
+
+	std::string name(uint32_t begin, uint32_t end) const {
+		return std::string(names.data + begin, names.data + end);
+	}
+	std::string buffer_name(Buffer const &buffer) const {
+		return std::string(buffer_names.data + buffer.name_begin, buffer_names.data + buffer.name_end);
+	}
+
+	//copies of the sections, for tools that change a cooked scene and build a new block:
+	struct Contents {
+		std::vector< char > names;
+		std::vector< Transform > transforms;
+		std::vector< Drawable > drawables;
+		std::vector< Camera > cameras;
+		std::vector< Light > lights;
+		std::vector< char > buffer_names;
+		std::vector< Buffer > buffers;
+		std::vector< MeshRef > mesh_refs;
+	};
+	Contents contents() const;
+	static std::vector< char > make_block(Contents const &contents);
+
+	//the whole block (e.g., for writing to a 'csn0' chunk):
+	char const *block = nullptr;
+	uint64_t block_size = 0;
+
+	//-- internals ---
+	std::vector< char > storage; //holds the block when it isn't mapped
+	void *mapping = nullptr; //mapped file (if any)
+	size_t mapping_size = 0;
+
+	void load(ChunkFile &file); //(shared by the constructors)
+	void cook(ChunkFile &file); //build the block in 'storage' from plain scene chunks
+	void set_block(char const *block, uint64_t block_size, std::string const &filename); //check the block and find its sections
+};
@@ -1,24 +1,151 @@
 #include "DrawLines.hpp"
 #include "PathFont.hpp"
 #include "ColorProgram.hpp"
+#include "GlyphProgram.hpp"
+#include "WideLineProgram.hpp"
+#include "StreamBuffer.hpp"
+#include "FrameArena.hpp"
 
 #include "gl_errors.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
-//All DrawLines instances share a vertex array object and vertex buffer, initialized at load time:
+#include <algorithm>
+#include <cassert>
+#include <deque>
 
-//n.b. declared static so they don't conflict with similarly named global variables elsewhere:
-static GLuint vertex_buffer = 0;
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define DRAW_LINES_SSE
+#endif
+
+//All DrawLines instances share a vertex array object, initialized at load time,
+// and batches write their vertices to the shared stream buffer (see StreamBuffer.hpp):
+
+//n.b. declared static so it doesn't conflict with similarly named global variables elsewhere:
 static GLuint vertex_buffer_for_color_program = 0;
 
-static Load< void > setup_buffers(LoadTagDefault, [](){
-	//you may recognize this init code from DrawSprites.cpp:
+//Text is drawn as instances of glyph outlines, all uploaded once to glyph_buffer:
+// (glyph g's points start at PathFont::font.glyph_coord_starts[g] / 2, and the 'missing' box comes last)
+static GLuint glyph_buffer = 0;
+static GLuint glyph_buffer_for_glyph_program = 0;
+
+//Wide lines are drawn as instances of a quad, with only per-instance attributes (from the stream buffer):
+static GLuint vertex_buffer_for_wide_line_program = 0;
+
+//outline of the box drawn for missing glyphs:
+static glm::vec2 const missing_glyph[8] = {
+	glm::vec2(0.1f, 0.1f), glm::vec2(0.6f, 0.1f),
+	glm::vec2(0.6f, 0.1f), glm::vec2(0.6f, 0.9f),
+	glm::vec2(0.9f, 0.6f), glm::vec2(0.1f, 0.9f),
+	glm::vec2(0.1f, 0.9f), glm::vec2(0.1f, 0.1f)
+};
+static constexpr float missing_glyph_width = 0.6f;
+
+//where the lines of any glyph (or the 'missing' box) can be, relative to its anchor:
+// (x past the right is measured from the glyph's advance, so a run of text of total advance W
+//  lies within [min_x, W + max_x_past] x [min_y, max_y])
+struct GlyphExtent {
+	float min_x, max_x_past, min_y, max_y;
+};
+static GlyphExtent const &glyph_extent() {
+	static GlyphExtent const extent = [](){
+		PathFont const &font = PathFont::font;
+		GlyphExtent ret{0.0f, 0.0f, 0.0f, 1.0f}; //(at least the character box)
+		for (uint32_t g = 0; g < font.glyphs; ++g) {
+			for (uint32_t c = font.glyph_coord_starts[g]; c + 1 < font.glyph_coord_starts[g+1]; c += 2) {
+				ret.min_x = std::min(ret.min_x, font.coords[c]);
+				ret.max_x_past = std::max(ret.max_x_past, font.coords[c] - font.glyph_widths[g]);
+				ret.min_y = std::min(ret.min_y, font.coords[c+1]);
+				ret.max_y = std::max(ret.max_y, font.coords[c+1]);
+			}
+		}
+		for (glm::vec2 const &pt : missing_glyph) {
+			ret.min_x = std::min(ret.min_x, pt.x);
+			ret.max_x_past = std::max(ret.max_x_past, pt.x - missing_glyph_width);
+			ret.min_y = std::min(ret.min_y, pt.y);
+			ret.max_y = std::max(ret.max_y, pt.y);
+		}
+		return ret;
+	}();
+	return extent;
+}
 
-	{ //set up vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
+//is the parallelepiped corner + [0,1]*a + [0,1]*b + [0,1]*c (in world space) entirely outside one of the clip planes of world_to_clip?
+// (if so, nothing inside it can be seen; boxes that straddle the planes or surround the camera are kept)
+static bool outside_clip(glm::mat4 const &world_to_clip, glm::vec3 const &corner, glm::vec3 const &a, glm::vec3 const &b, glm::vec3 const &c) {
+	#ifdef DRAW_LINES_SSE
+	//transform to clip space, one matrix column per register:
+	__m128 col[4];
+	for (uint32_t i = 0; i < 4; ++i) {
+		col[i] = _mm_loadu_ps(glm::value_ptr(world_to_clip[i]));
 	}
+	auto transform = [&col](glm::vec3 const &v, __m128 w) {
+		return _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(col[0], _mm_set1_ps(v.x)), _mm_mul_ps(col[1], _mm_set1_ps(v.y))),
+			_mm_add_ps(_mm_mul_ps(col[2], _mm_set1_ps(v.z)), _mm_mul_ps(col[3], w))
+		);
+	};
+	__m128 p0 = transform(corner, _mm_set1_ps(1.0f));
+	__m128 da = transform(a, _mm_setzero_ps());
+	__m128 db = transform(b, _mm_setzero_ps());
+	__m128 dc = transform(c, _mm_setzero_ps());
+
+	__m128 p1 = _mm_add_ps(p0, da);
+	__m128 p[8] = {
+		p0, p1, _mm_add_ps(p0, db), _mm_add_ps(p1, db),
+	};
+	for (uint32_t i = 0; i < 4; ++i) {
+		p[4 + i] = _mm_add_ps(p[i], dc);
+	}
+
+	//lanes x,y,z of 'above' ('below') stay set if every corner is beyond +w (-w) in that coordinate:
+	__m128 above = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+	__m128 below = above;
+	for (uint32_t i = 0; i < 8; ++i) {
+		__m128 w = _mm_shuffle_ps(p[i], p[i], _MM_SHUFFLE(3,3,3,3));
+		above = _mm_and_ps(above, _mm_cmpgt_ps(p[i], w));
+		below = _mm_and_ps(below, _mm_cmplt_ps(p[i], _mm_sub_ps(_mm_setzero_ps(), w)));
+	}
+	//(lane w compares w with itself, so is ignored)
+	return (_mm_movemask_ps(_mm_or_ps(above, below)) & 0x7) != 0;
+	#else
+	glm::vec4 p0 = world_to_clip * glm::vec4(corner, 1.0f);
+	glm::vec4 da = world_to_clip * glm::vec4(a, 0.0f);
+	glm::vec4 db = world_to_clip * glm::vec4(b, 0.0f);
+	glm::vec4 dc = world_to_clip * glm::vec4(c, 0.0f);
+
+	//above[k] (below[k]) stays set if every corner is beyond +w (-w) in coordinate k:
+	bool above[3] = {true, true, true};
+	bool below[3] = {true, true, true};
+	for (uint32_t i = 0; i < 8; ++i) {
+		glm::vec4 p = p0;
+		if (i & 1) p += da;
+		if (i & 2) p += db;
+		if (i & 4) p += dc;
+		for (uint32_t k = 0; k < 3; ++k) {
+			above[k] = above[k] && p[k] > p.w;
+			below[k] = below[k] && p[k] < -p.w;
+		}
+	}
+	return above[0] || above[1] || above[2] || below[0] || below[1] || below[2];
+	#endif
+}
+
+//range of glyph_buffer holding the outline of a glyph:
+static void glyph_points(uint32_t glyph, GLint *first, GLsizei *count) {
+	PathFont const &font = PathFont::font;
+	if (glyph < font.glyphs) {
+		*first = GLint(font.glyph_coord_starts[glyph] / 2);
+		*count = GLsizei((font.glyph_coord_starts[glyph+1] - font.glyph_coord_starts[glyph]) / 2);
+	} else {
+		*first = GLint(font.glyph_coord_starts[font.glyphs] / 2);
+		*count = GLsizei(sizeof(missing_glyph) / sizeof(missing_glyph[0]));
+	}
+}
+
+static Load< void > setup_buffers(LoadTagDefault, [](){
+	//you may recognize this init code from DrawSprites.cpp:
 
 	{ //vertex array mapping buffer for color_program:
 		//ask OpenGL to fill vertex_buffer_for_color_program with the name of an unused vertex array object:
@@ -27,8 +154,8 @@ static Load< void > setup_buffers(LoadTagDefault, [](){
 		//set vertex_buffer_for_color_program as the current vertex array object:
 		glBindVertexArray(vertex_buffer_for_color_program);
 
-		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		//set the stream buffer as the source of glVertexAttribPointer() commands:
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_stream().buffer);
 
 		//set up the vertex array object to describe arrays of PongMode::Vertex:
 		glVertexAttribPointer(
@@ -52,18 +179,91 @@ static Load< void > setup_buffers(LoadTagDefault, [](){
 		);
 		glEnableVertexAttribArray(color_program->Color_vec4);
 
-		//done referring to vertex_buffer, so unbind it:
+		//done referring to the stream buffer, so unbind it:
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		//done setting up vertex array object, so unbind it:
 		glBindVertexArray(0);
 	}
 
+	{ //upload glyph outlines (the font's coordinates, then the 'missing' box):
+		PathFont const &font = PathFont::font;
+		std::vector< glm::vec2 > points;
+		points.reserve(font.glyph_coord_starts[font.glyphs] / 2 + sizeof(missing_glyph) / sizeof(missing_glyph[0]));
+		for (uint32_t c = 0; c + 1 < font.glyph_coord_starts[font.glyphs]; c += 2) {
+			points.emplace_back(font.coords[c], font.coords[c+1]);
+		}
+		points.insert(points.end(), missing_glyph, missing_glyph + sizeof(missing_glyph) / sizeof(missing_glyph[0]));
+
+		glGenBuffers(1, &glyph_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, glyph_buffer);
+		glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(points[0]), points.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	{ //vertex array for glyph_program:
+		glGenVertexArrays(1, &glyph_buffer_for_glyph_program);
+		glBindVertexArray(glyph_buffer_for_glyph_program);
+
+		//per-vertex points come from glyph_buffer:
+		glBindBuffer(GL_ARRAY_BUFFER, glyph_buffer);
+		glVertexAttribPointer(glyph_program->Point_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (GLbyte *)0);
+		glEnableVertexAttribArray(glyph_program->Point_vec2);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		//per-instance attributes come from the stream buffer (pointed at each glyph's instances when drawing):
+		for (GLuint attribute : {glyph_program->Anchor_vec3, glyph_program->X_vec3, glyph_program->Y_vec3, glyph_program->Color_vec4}) {
+			glEnableVertexAttribArray(attribute);
+			glVertexAttribDivisor(attribute, 1);
+		}
+
+		glBindVertexArray(0);
+	}
+
+	{ //vertex array for wide_line_program:
+		glGenVertexArrays(1, &vertex_buffer_for_wide_line_program);
+		glBindVertexArray(vertex_buffer_for_wide_line_program);
+		//(attributes are pointed at each batch's segments when drawing)
+		for (GLuint attribute : {wide_line_program->A_vec3, wide_line_program->B_vec3, wide_line_program->Color_vec4, wide_line_program->Width_float}) {
+			glEnableVertexAttribArray(attribute);
+			glVertexAttribDivisor(attribute, 1);
+		}
+		glBindVertexArray(0);
+	}
+
 	GL_ERRORS(); //PARANOIA: make sure nothing strange happened during setup
-});
+}, "DrawLines buffers");
+
+
+//batches of the current frame (the first batch_count of batches; the rest are kept to reuse their storage):
+static std::deque< DrawLines::Batch > batches; //(deque, so adding batches doesn't move earlier ones)
+static size_t batch_count = 0;
+
+static DrawLines::Batch &find_batch(glm::mat4 const &world_to_clip) {
+	GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+	GLint depth_func = GL_LESS;
+	glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
 
+	//(frames rarely have more than a few batches, so search them in order)
+	for (size_t i = 0; i < batch_count; ++i) {
+		DrawLines::Batch &batch = batches[i];
+		if (batch.world_to_clip == world_to_clip && batch.depth_test == depth_test && batch.depth_func == depth_func) return batch;
+	}
+
+	if (batch_count == batches.size()) batches.emplace_back();
+	DrawLines::Batch &batch = batches[batch_count++];
+	batch.world_to_clip = world_to_clip;
+	batch.depth_test = depth_test;
+	batch.depth_func = depth_func;
+	batch.attribs.clear();
+	batch.glyphs.clear();
+	batch.wide.clear();
+	batch.smooth_wide.clear();
+	return batch;
+}
 
-DrawLines::DrawLines(glm::mat4 const &world_to_clip_) : world_to_clip(world_to_clip_) {
+DrawLines::DrawLines(glm::mat4 const &world_to_clip_) : world_to_clip(world_to_clip_),
+	batch(find_batch(world_to_clip_)), attribs(batch.attribs), glyphs(batch.glyphs) {
 }
 
 void DrawLines::draw(glm::vec3 const &a, glm::vec3 const &b, glm::u8vec4 const &color) {
@@ -71,88 +271,120 @@ void DrawLines::draw(glm::vec3 const &a, glm::vec3 const &b, glm::u8vec4 const &
 	attribs.emplace_back(b, color);
 }
 
+void DrawLines::draw_wide(glm::vec3 const &a, glm::vec3 const &b, float width, glm::u8vec4 const &color, bool smooth) {
+	(smooth ? batch.smooth_wide : batch.wide).emplace_back(WideSegment{a, b, color, width});
+}
+
 void DrawLines::draw_box(glm::mat4x3 const &mat, glm::u8vec4 const &color) {
-	//draw cube as three edge sets:
+	//skip boxes that can't be seen:
+	if (outside_clip(world_to_clip, mat[3] - mat[0] - mat[1] - mat[2], 2.0f * mat[0], 2.0f * mat[1], 2.0f * mat[2])) return;
 
-	draw(mat * glm::vec4(-1.0f,-1.0f,-1.0f, 1.0f), mat * glm::vec4( 1.0f,-1.0f,-1.0f, 1.0f), color);
-	draw(mat * glm::vec4(-1.0f, 1.0f,-1.0f, 1.0f), mat * glm::vec4( 1.0f, 1.0f,-1.0f, 1.0f), color);
-	draw(mat * glm::vec4(-1.0f,-1.0f, 1.0f, 1.0f), mat * glm::vec4( 1.0f,-1.0f, 1.0f, 1.0f), color);
-	draw(mat * glm::vec4(-1.0f, 1.0f, 1.0f, 1.0f), mat * glm::vec4( 1.0f, 1.0f, 1.0f, 1.0f), color);
+	//corners, indexed by (x > 0) + 2 * (y > 0) + 4 * (z > 0):
+	glm::vec3 corners[8];
+	for (uint32_t i = 0; i < 8; ++i) {
+		corners[i] = mat * glm::vec4((i & 1 ? 1.0f : -1.0f), (i & 2 ? 1.0f : -1.0f), (i & 4 ? 1.0f : -1.0f), 1.0f);
+	}
 
-	draw(mat * glm::vec4(-1.0f,-1.0f,-1.0f, 1.0f), mat * glm::vec4(-1.0f, 1.0f,-1.0f, 1.0f), color);
-	draw(mat * glm::vec4( 1.0f,-1.0f,-1.0f, 1.0f), mat * glm::vec4( 1.0f, 1.0f,-1.0f, 1.0f), color);
-	draw(mat * glm::vec4(-1.0f,-1.0f, 1.0f, 1.0f), mat * glm::vec4(-1.0f, 1.0f, 1.0f, 1.0f), color);
-	draw(mat * glm::vec4( 1.0f,-1.0f, 1.0f, 1.0f), mat * glm::vec4( 1.0f, 1.0f, 1.0f, 1.0f), color);
-	
-	draw(mat * glm::vec4(-1.0f,-1.0f,-1.0f, 1.0f), mat * glm::vec4(-1.0f,-1.0f, 1.0f, 1.0f), color);
-	draw(mat * glm::vec4( 1.0f,-1.0f,-1.0f, 1.0f), mat * glm::vec4( 1.0f,-1.0f, 1.0f, 1.0f), color);
-	draw(mat * glm::vec4(-1.0f, 1.0f,-1.0f, 1.0f), mat * glm::vec4(-1.0f, 1.0f, 1.0f, 1.0f), color);
-	draw(mat * glm::vec4( 1.0f, 1.0f,-1.0f, 1.0f), mat * glm::vec4( 1.0f, 1.0f, 1.0f, 1.0f), color);
+	//draw cube as three edge sets:
+	for (uint32_t axis : {1, 2, 4}) {
+		for (uint32_t i = 0; i < 8; ++i) {
+			if (i & axis) continue;
+			draw(corners[i], corners[i | axis], color);
+		}
+	}
 }
 
-void DrawLines::draw_text(std::string const &text, glm::vec3 const &anchor_in, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &color, glm::vec3 *anchor_out) {
+//append lines for 'text' to 'attribs', placed as by draw_text:
+// (used by DrawLines::Text, which keeps the lines themselves rather than glyph instances)
+static void layout_text(char const *begin, char const *end, glm::vec3 const &anchor_in, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &color, FrameVector< DrawLines::Vertex > *attribs_, glm::vec3 *anchor_out) {
+	assert(attribs_);
+	auto &attribs = *attribs_;
 
 	glm::vec3 anchor = anchor_in;
 
-	uint32_t start = 0;
-	while (start < text.size()) {
-		uint32_t end = start;
-		uint32_t glyph = -1U;
-		while (end < text.size()) {
-			end += 1;
-			auto f = PathFont::font.glyph_map.find(text.substr(start, end-start));
-			if (f == PathFont::font.glyph_map.end()) {
-				end -= 1;
-				break;
-			}
-			glyph = f->second;
-		}
+	char const *at = begin;
+	while (at < end) {
+		uint32_t length = 0;
+		uint32_t glyph = PathFont::font.match(at, end, &length);
 		if (glyph == -1U) {
-			assert(start == end);
-			end += 1;
+			length = 1;
 			//missing! draw a tofu:
-			for (const auto &pt : {
-				glm::vec2(0.1f, 0.1f), glm::vec2(0.6f, 0.1f),
-				glm::vec2(0.6f, 0.1f), glm::vec2(0.6f, 0.9f),
-				glm::vec2(0.9f, 0.6f), glm::vec2(0.1f, 0.9f),
-				glm::vec2(0.1f, 0.9f), glm::vec2(0.1f, 0.1f)
-			}) {
+			for (glm::vec2 const &pt : missing_glyph) {
 				attribs.emplace_back(anchor + pt.x * x + pt.y * y, color);
 			}
-			anchor += x * 0.6f;
+			anchor += x * missing_glyph_width;
 		} else {
 			for (uint32_t c = PathFont::font.glyph_coord_starts[glyph]; c + 1 < PathFont::font.glyph_coord_starts[glyph+1]; c += 2) {
 				attribs.emplace_back(anchor + x * PathFont::font.coords[c] + y * PathFont::font.coords[c+1], color);
 			}
 			anchor += x * PathFont::font.glyph_widths[glyph];
 		}
-		start = end;
+		at += length;
 	}
 
 	if (anchor_out) *anchor_out = anchor;
 }
 
-DrawLines::~DrawLines() {
-	if (attribs.empty()) return;
+void DrawLines::draw_text(char const *begin, char const *end, glm::vec3 const &anchor_in, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &color, glm::vec3 *anchor_out) {
+	PathFont const &font = PathFont::font;
+
+	glm::vec3 anchor = anchor_in;
+	size_t first_glyph = glyphs.size();
+
+	char const *at = begin;
+	while (at < end) {
+		uint32_t length = 0;
+		uint32_t glyph = font.match(at, end, &length);
+		if (glyph == -1U) {
+			//missing! draw a tofu:
+			length = 1;
+			glyphs.emplace_back(GlyphInstance{anchor, x, y, color, font.glyphs});
+			anchor += x * missing_glyph_width;
+		} else {
+			if (font.glyph_coord_starts[glyph] != font.glyph_coord_starts[glyph+1]) { //(e.g., spaces have no lines)
+				glyphs.emplace_back(GlyphInstance{anchor, x, y, color, glyph});
+			}
+			anchor += x * font.glyph_widths[glyph];
+		}
+		at += length;
+	}
+
+	//take back the glyphs if the whole run can't be seen:
+	// (the run's total advance is only known once it is laid out; laying out is cheap next to drawing)
+	if (glyphs.size() > first_glyph) {
+		GlyphExtent const &extent = glyph_extent();
+		glm::vec3 run = anchor - anchor_in;
+		glm::vec3 corner = anchor_in + extent.min_x * x + extent.min_y * y;
+		glm::vec3 along = run + (extent.max_x_past - extent.min_x) * x;
+		glm::vec3 up = (extent.max_y - extent.min_y) * y;
+		if (outside_clip(world_to_clip, corner, along, up, glm::vec3(0.0f))) {
+			glyphs.resize(first_glyph);
+		}
+	}
+
+	if (anchor_out) *anchor_out = anchor;
+}
+
+static void draw_lines(DrawLines::Batch const &batch) {
+	auto const &attribs = batch.attribs;
 
 	//based on DrawSprites.cpp :
 
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, attribs.size() * sizeof(attribs[0]), attribs.data(), GL_STREAM_DRAW); //upload attribs array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	//append vertices to the stream buffer:
+	// (rather than re-specifying a buffer on every flush, which can stall or reallocate in the driver)
+	size_t offset = vertex_stream().write(attribs.data(), attribs.size() * sizeof(attribs[0]), sizeof(attribs[0]));
 
 	//set color_program as current program:
 	glUseProgram(color_program->program);
 
 	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+	glUniformMatrix4fv(color_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(batch.world_to_clip));
 
 	//use the mapping vertex_buffer_for_color_program to fetch vertex data:
 	glBindVertexArray(vertex_buffer_for_color_program);
 
 	//run the OpenGL pipeline:
-	glDrawArrays(GL_LINES, 0, GLsizei(attribs.size()));
+	glDrawArrays(GL_LINES, GLint(offset / sizeof(attribs[0])), GLsizei(attribs.size()));
 
 	//reset vertex array to none:
 	glBindVertexArray(0);
@@ -161,4 +393,195 @@ DrawLines::~DrawLines() {
 	glUseProgram(0);
 }
 
+static void draw_glyphs(DrawLines::Batch const &batch) {
+	using GlyphInstance = DrawLines::GlyphInstance;
+	PathFont const &font = PathFont::font;
+	auto const &glyphs = batch.glyphs;
+
+	//sort instances by glyph (counting sort), so each glyph's instances can be drawn together:
+	static std::vector< uint32_t > firsts; //(static so the storage is reused between flushes)
+	static std::vector< GlyphInstance > sorted;
+	firsts.assign(font.glyphs + 2, 0);
+	for (GlyphInstance const &g : glyphs) {
+		firsts[g.glyph + 1] += 1;
+	}
+	for (uint32_t g = 0; g + 1 < firsts.size(); ++g) {
+		firsts[g + 1] += firsts[g];
+	}
+	sorted.resize(glyphs.size());
+	for (GlyphInstance const &g : glyphs) {
+		sorted[firsts[g.glyph]++] = g;
+	}
+	//(firsts[g] is now the end of glyph g's instances, and so the start of glyph g+1's)
+
+	size_t offset = vertex_stream().write(sorted.data(), sorted.size() * sizeof(sorted[0]), sizeof(sorted[0]));
+
+	glUseProgram(glyph_program->program);
+	glUniformMatrix4fv(glyph_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(batch.world_to_clip));
+
+	glBindVertexArray(glyph_buffer_for_glyph_program);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_stream().buffer);
+
+	uint32_t begin = 0;
+	for (uint32_t glyph = 0; glyph <= font.glyphs; ++glyph) {
+		uint32_t end = firsts[glyph];
+		if (begin == end) continue;
+
+		//point the per-instance attributes at this glyph's instances:
+		GLbyte *base = (GLbyte *)0 + offset + begin * sizeof(GlyphInstance);
+		glVertexAttribPointer(glyph_program->Anchor_vec3, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), base + offsetof(GlyphInstance, anchor));
+		glVertexAttribPointer(glyph_program->X_vec3, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), base + offsetof(GlyphInstance, x));
+		glVertexAttribPointer(glyph_program->Y_vec3, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), base + offsetof(GlyphInstance, y));
+		glVertexAttribPointer(glyph_program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), base + offsetof(GlyphInstance, color));
+
+		GLint first;
+		GLsizei count;
+		glyph_points(glyph, &first, &count);
+		glDrawArraysInstanced(GL_LINES, first, count, GLsizei(end - begin));
+
+		begin = end;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+static void draw_wide_lines(DrawLines::Batch const &batch, std::vector< DrawLines::WideSegment > const &segments, float feather, glm::vec2 const &viewport_size) {
+	using WideSegment = DrawLines::WideSegment;
+
+	size_t offset = vertex_stream().write(segments.data(), segments.size() * sizeof(segments[0]), sizeof(segments[0]));
+
+	glUseProgram(wide_line_program->program);
+	glUniformMatrix4fv(wide_line_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(batch.world_to_clip));
+	glUniform2fv(wide_line_program->VIEWPORT_SIZE_vec2, 1, glm::value_ptr(viewport_size));
+	glUniform1f(wide_line_program->FEATHER_float, feather);
+
+	glBindVertexArray(vertex_buffer_for_wide_line_program);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_stream().buffer);
+	GLbyte *base = (GLbyte *)0 + offset;
+	glVertexAttribPointer(wide_line_program->A_vec3, 3, GL_FLOAT, GL_FALSE, sizeof(WideSegment), base + offsetof(WideSegment, a));
+	glVertexAttribPointer(wide_line_program->B_vec3, 3, GL_FLOAT, GL_FALSE, sizeof(WideSegment), base + offsetof(WideSegment, b));
+	glVertexAttribPointer(wide_line_program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(WideSegment), base + offsetof(WideSegment, color));
+	glVertexAttribPointer(wide_line_program->Width_float, 1, GL_FLOAT, GL_FALSE, sizeof(WideSegment), base + offsetof(WideSegment, width));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//one quad (as a four-vertex strip) per segment:
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(segments.size()));
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+void DrawLines::flush() {
+	if (batch_count == 0) return;
+
+	//state changed while drawing batches, to be restored afterward:
+	GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+	GLint depth_func = GL_LESS;
+	glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	GLint blend_src_rgb = GL_ONE, blend_dst_rgb = GL_ZERO, blend_src_alpha = GL_ONE, blend_dst_alpha = GL_ZERO;
+	glGetIntegerv(GL_BLEND_SRC_RGB, &blend_src_rgb);
+	glGetIntegerv(GL_BLEND_DST_RGB, &blend_dst_rgb);
+	glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend_src_alpha);
+	glGetIntegerv(GL_BLEND_DST_ALPHA, &blend_dst_alpha);
+
+	//wide lines are sized in pixels, so need the viewport's size:
+	GLint viewport[4] = {0, 0, 1, 1};
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glm::vec2 viewport_size = glm::vec2(viewport[2], viewport[3]);
+
+	//draw batches in the order they were started:
+	for (size_t i = 0; i < batch_count; ++i) {
+		Batch const &batch = batches[i];
+		if (batch.attribs.empty() && batch.glyphs.empty() && batch.wide.empty() && batch.smooth_wide.empty()) continue;
+
+		if (batch.depth_test) glEnable(GL_DEPTH_TEST);
+		else glDisable(GL_DEPTH_TEST);
+		glDepthFunc(batch.depth_func);
+
+		if (!batch.attribs.empty()) draw_lines(batch);
+		if (!batch.wide.empty()) draw_wide_lines(batch, batch.wide, 0.0f, viewport_size);
+		if (!batch.glyphs.empty()) draw_glyphs(batch);
+		if (!batch.smooth_wide.empty()) {
+			//(last, so they blend over the rest of the batch)
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			draw_wide_lines(batch, batch.smooth_wide, 1.0f, viewport_size);
+			if (!blend) glDisable(GL_BLEND);
+			glBlendFuncSeparate(blend_src_rgb, blend_dst_rgb, blend_src_alpha, blend_dst_alpha);
+		}
+	}
+	batch_count = 0;
+
+	if (depth_test) glEnable(GL_DEPTH_TEST);
+	else glDisable(GL_DEPTH_TEST);
+	glDepthFunc(depth_func);
+}
+
+
+DrawLines::Text::~Text() {
+	if (vao != 0) glDeleteVertexArrays(1, &vao);
+	if (buffer != 0) glDeleteBuffers(1, &buffer);
+}
+
+void DrawLines::Text::set(char const *begin, char const *end) {
+	if (vao != 0 && text.compare(0, text.size(), begin, end - begin) == 0) return;
+	text.assign(begin, end); //(reuses text's storage when it is big enough)
+
+	//(the laid-out lines are only needed until they are uploaded, so come from the frame arena)
+	FrameVector< Vertex > attribs;
+	attribs.reserve(64 * text.size()); //(glyphs average about 50 points; reserving keeps growth from wasting arena space)
+	glm::vec3 after;
+	layout_text(text.data(), text.data() + text.size(), glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::u8vec4(0xff), &attribs, &after);
+	width = after.x;
+
+	if (vao == 0) {
+		glGenBuffers(1, &buffer);
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glVertexAttribPointer(
+			color_program->Position_vec4, //attribute
+			3, //size
+			GL_FLOAT, //type
+			GL_FALSE, //normalized
+			sizeof(DrawLines::Vertex), //stride
+			(GLbyte *)0 + offsetof(DrawLines::Vertex, Position) //offset
+		);
+		glEnableVertexAttribArray(color_program->Position_vec4);
+		//(Color_vec4 is left disabled, so it reads the value set by glVertexAttrib4f in draw())
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, attribs.size() * sizeof(attribs[0]), attribs.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	count = GLsizei(attribs.size());
+
+	GL_ERRORS();
+}
 
+void DrawLines::Text::draw(glm::mat4 const &world_to_clip, glm::vec3 const &anchor, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &color) const {
+	if (count == 0) return;
+
+	//text was laid out along the unit axes, so place it with a matrix:
+	glm::mat4 text_to_world(
+		glm::vec4(x, 0.0f),
+		glm::vec4(y, 0.0f),
+		glm::vec4(0.0f, 0.0f, 0.0f, 0.0f), //(text has no depth)
+		glm::vec4(anchor, 1.0f)
+	);
+
+	glUseProgram(color_program->program);
+	glUniformMatrix4fv(color_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(world_to_clip * text_to_world));
+	glVertexAttrib4f(color_program->Color_vec4, color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f);
+
+	glBindVertexArray(vao);
+	glDrawArrays(GL_LINES, 0, count);
+	glBindVertexArray(0);
+
+	glUseProgram(0);
+}
@@ -6,35 +6,61 @@
  *
  * Similar usage pattern to DrawSprites.
  *
+ * Lines and text from every DrawLines made during a frame are collected into
+ *  batches (one per world_to_clip matrix and depth test state) and drawn
+ *  together by DrawLines::flush(), which main calls once the mode has drawn.
+ *
  */
 
 
+#include "GL.hpp"
+
 #include <glm/glm.hpp>
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 struct DrawLines {
 	//Start drawing; will remember world_to_clip matrix:
+	// (and the current depth test state, which is restored when the batch is drawn)
 	DrawLines(glm::mat4 const &world_to_clip);
 
 	//draw a single line from a to b (in world space):
 	void draw(glm::vec3 const &a, glm::vec3 const &b, glm::u8vec4 const &color = glm::u8vec4(0xff));
 
+	//draw a line from a to b (in world space) that is 'width' pixels wide:
+	// (expanded to a quad on the GPU, so costs about the same to draw as a line from draw())
+	// (if 'smooth', edges fade out over a pixel, blended with what is behind; otherwise the current blend state is used)
+	void draw_wide(glm::vec3 const &a, glm::vec3 const &b, float width, glm::u8vec4 const &color = glm::u8vec4(0xff), bool smooth = true);
+
 	//draw a wireframe box corresponding to the [-1,1]^3 cube transformed by mat:
+	// (boxes entirely outside the view of world_to_clip are skipped)
 	void draw_box(glm::mat4x3 const &mat, glm::u8vec4 const &color = glm::u8vec4(0xff));
 
 	//draw wireframe text, start at anchor, move in x direction, mat gives x and y directions for text drawing:
 	// (default character box is 1 unit high)
+	// (records one instance per character; glyph outlines are drawn from a buffer uploaded at load time)
+	// (text entirely outside the view of world_to_clip records nothing, though anchor_out is still set)
 	void draw_text(std::string const &text,
+		glm::vec3 const &anchor,
+		glm::vec3 const &x = glm::vec3(1.0f, 0.0f, 0.0f),
+		glm::vec3 const &y = glm::vec3(0.0f, 1.0f, 1.0f),
+		glm::u8vec4 const &color = glm::u8vec4(0xff),
+		glm::vec3 *anchor_out = nullptr) {
+		draw_text(text.data(), text.data() + text.size(), anchor, x, y, color, anchor_out);
+	}
+	//same, for the characters [begin,end) (e.g., of a FrameString; see FrameArena.hpp):
+	void draw_text(char const *begin, char const *end,
 		glm::vec3 const &anchor,
 		glm::vec3 const &x = glm::vec3(1.0f, 0.0f, 0.0f),
 		glm::vec3 const &y = glm::vec3(0.0f, 1.0f, 1.0f),
 		glm::u8vec4 const &color = glm::u8vec4(0xff),
 		glm::vec3 *anchor_out = nullptr);
 
-	//Finish drawing (push attribs to GPU):
-	~DrawLines();
+	//Draw (push attribs and glyphs to GPU) everything drawn by DrawLines since the last flush:
+	// (call once per frame, after the mode draws; leaves the depth test state as it found it)
+	static void flush();
 
 
 	glm::mat4 world_to_clip;
@@ -43,6 +69,64 @@ struct DrawLines {
 		glm::vec3 Position;
 		glm::u8vec4 Color;
 	};
-	std::vector< Vertex > attribs;
 
+	//a character drawn by draw_text:
+	struct GlyphInstance {
+		glm::vec3 anchor;
+		glm::vec3 x, y;
+		glm::u8vec4 color;
+		uint32_t glyph; //index in PathFont::font (or PathFont::font.glyphs for a 'missing' box)
+	};
+
+	//a line drawn by draw_wide:
+	struct WideSegment {
+		glm::vec3 a, b;
+		glm::u8vec4 color;
+		float width; //in pixels
+	};
+
+	//lines and text drawn during a frame with the same world_to_clip and depth test state:
+	struct Batch {
+		glm::mat4 world_to_clip;
+		GLboolean depth_test = GL_FALSE;
+		GLint depth_func = GL_LESS;
+		std::vector< Vertex > attribs;
+		std::vector< GlyphInstance > glyphs;
+		std::vector< WideSegment > wide; //hard-edged
+		std::vector< WideSegment > smooth_wide; //anti-aliased
+	};
+	Batch &batch;
+	//(this DrawLines appends to its batch's arrays)
+	std::vector< Vertex > &attribs;
+	std::vector< GlyphInstance > &glyphs;
+
+	//Text laid out once and kept in its own buffer, for strings drawn every frame that rarely change (e.g., HUD text):
+	// (drawn immediately, rather than batched until DrawLines::flush())
+	struct Text {
+		Text() = default;
+		~Text();
+		//(owns a buffer, so can't be copied)
+		Text(Text const &) = delete;
+		Text &operator=(Text const &) = delete;
+
+		//lay out 'text' (only if it differs from the current text):
+		void set(std::string const &text) { set(text.data(), text.data() + text.size()); }
+		//same, for the characters [begin,end):
+		void set(char const *begin, char const *end);
+
+		//draw with the same placement as draw_text, but without laying anything out:
+		void draw(glm::mat4 const &world_to_clip,
+			glm::vec3 const &anchor,
+			glm::vec3 const &x = glm::vec3(1.0f, 0.0f, 0.0f),
+			glm::vec3 const &y = glm::vec3(0.0f, 1.0f, 1.0f),
+			glm::u8vec4 const &color = glm::u8vec4(0xff)) const;
+
+		std::string text;
+		float width = 0.0f; //distance the anchor moves along 'x' over the whole text
+
+		//lines of the text with anchor (0,0,0), x (1,0,0), and y (0,1,0):
+		GLuint buffer = 0;
+		GLuint vao = 0; //(reads positions only; color is set per draw)
+		GLsizei count = 0;
+	};
 };
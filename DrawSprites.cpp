@@ -0,0 +1,206 @@
+#include "DrawSprites.hpp"
+#include "ColorTextureProgram.hpp"
+#include "StreamBuffer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+
+//All DrawSprites instances share a vertex array object and an index buffer, initialized at load time,
+// and batches write their vertices to the shared stream buffer (see StreamBuffer.hpp):
+
+//n.b. declared static so they don't conflict with similarly named global variables elsewhere:
+static GLuint index_buffer = 0;
+static GLuint index_buffer_quads = 0; //quads index_buffer has indices for
+static GLuint vertex_buffer_for_color_texture_program = 0;
+
+//make sure index_buffer has indices for at least 'quads' quads:
+// (each quad is vertices 0,1,2,3 = lower left, lower right, upper left, upper right)
+static void reserve_quad_indices(GLuint quads) {
+	if (quads <= index_buffer_quads) return;
+	index_buffer_quads = std::max(quads, 2 * index_buffer_quads);
+
+	std::vector< GLuint > indices;
+	indices.reserve(index_buffer_quads * 6);
+	for (GLuint q = 0; q < index_buffer_quads; ++q) {
+		GLuint v = 4 * q;
+		for (GLuint i : {v+0, v+1, v+2, v+2, v+1, v+3}) {
+			indices.emplace_back(i);
+		}
+	}
+
+	//(binding the vertex array object first so its element array binding isn't changed)
+	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+}
+
+static Load< void > setup_buffers(LoadTagDefault, [](){
+	glGenBuffers(1, &index_buffer);
+
+	{ //vertex array mapping buffers for color_texture_program:
+		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
+		glBindVertexArray(vertex_buffer_for_color_texture_program);
+
+		//vertices come from the stream buffer:
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_stream().buffer);
+		glVertexAttribPointer(
+			color_texture_program->Position_vec4, //attribute
+			3, //size
+			GL_FLOAT, //type
+			GL_FALSE, //normalized
+			sizeof(DrawSprites::Vertex), //stride
+			(GLbyte *)0 + offsetof(DrawSprites::Vertex, Position) //offset
+		);
+		glEnableVertexAttribArray(color_texture_program->Position_vec4);
+
+		glVertexAttribPointer(
+			color_texture_program->Color_vec4, //attribute
+			4, //size
+			GL_UNSIGNED_BYTE, //type
+			GL_TRUE, //normalized
+			sizeof(DrawSprites::Vertex), //stride
+			(GLbyte *)0 + offsetof(DrawSprites::Vertex, Color) //offset
+		);
+		glEnableVertexAttribArray(color_texture_program->Color_vec4);
+
+		glVertexAttribPointer(
+			color_texture_program->TexCoord_vec2, //attribute
+			2, //size
+			GL_FLOAT, //type
+			GL_FALSE, //normalized
+			sizeof(DrawSprites::Vertex), //stride
+			(GLbyte *)0 + offsetof(DrawSprites::Vertex, TexCoord) //offset
+		);
+		glEnableVertexAttribArray(color_texture_program->TexCoord_vec2);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		//indices come from index_buffer (element array bindings are part of the vertex array object):
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+
+	reserve_quad_indices(1024);
+
+	GL_ERRORS(); //PARANOIA: make sure nothing strange happened during setup
+}, "DrawSprites buffers");
+
+
+//batches of the current frame (the first batch_count of batches; the rest are kept to reuse their storage):
+static std::deque< DrawSprites::Batch > batches; //(deque, so adding batches doesn't move earlier ones)
+static size_t batch_count = 0;
+
+static DrawSprites::Batch &find_batch(SpriteAtlas const &atlas, glm::mat4 const &world_to_clip) {
+	GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+	GLint depth_func = GL_LESS;
+	glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+
+	for (size_t i = 0; i < batch_count; ++i) {
+		DrawSprites::Batch &batch = batches[i];
+		if (batch.atlas == &atlas && batch.world_to_clip == world_to_clip && batch.depth_test == depth_test && batch.depth_func == depth_func) return batch;
+	}
+
+	if (batch_count == batches.size()) batches.emplace_back();
+	DrawSprites::Batch &batch = batches[batch_count++];
+	batch.atlas = &atlas;
+	batch.world_to_clip = world_to_clip;
+	batch.depth_test = depth_test;
+	batch.depth_func = depth_func;
+	batch.pages.resize(atlas.pages.size());
+	for (auto &page : batch.pages) {
+		page.clear();
+	}
+	return batch;
+}
+
+DrawSprites::DrawSprites(SpriteAtlas const &atlas, glm::mat4 const &world_to_clip) : batch(find_batch(atlas, world_to_clip)) {
+}
+
+void DrawSprites::draw(Sprite const &sprite, glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &tint) {
+	assert(sprite.page < batch.pages.size() && "sprite is from this DrawSprites' atlas");
+	std::vector< Vertex > &attribs = batch.pages[sprite.page];
+	attribs.emplace_back(glm::vec3(min.x, min.y, 0.0f), tint, glm::vec2(sprite.min_tc.x, sprite.min_tc.y));
+	attribs.emplace_back(glm::vec3(max.x, min.y, 0.0f), tint, glm::vec2(sprite.max_tc.x, sprite.min_tc.y));
+	attribs.emplace_back(glm::vec3(min.x, max.y, 0.0f), tint, glm::vec2(sprite.min_tc.x, sprite.max_tc.y));
+	attribs.emplace_back(glm::vec3(max.x, max.y, 0.0f), tint, glm::vec2(sprite.max_tc.x, sprite.max_tc.y));
+}
+
+void DrawSprites::draw(Sprite const &sprite, glm::vec3 const &corner, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &tint) {
+	assert(sprite.page < batch.pages.size() && "sprite is from this DrawSprites' atlas");
+	std::vector< Vertex > &attribs = batch.pages[sprite.page];
+	attribs.emplace_back(corner, tint, glm::vec2(sprite.min_tc.x, sprite.min_tc.y));
+	attribs.emplace_back(corner + x, tint, glm::vec2(sprite.max_tc.x, sprite.min_tc.y));
+	attribs.emplace_back(corner + y, tint, glm::vec2(sprite.min_tc.x, sprite.max_tc.y));
+	attribs.emplace_back(corner + x + y, tint, glm::vec2(sprite.max_tc.x, sprite.max_tc.y));
+}
+
+void DrawSprites::flush() {
+	if (batch_count == 0) return;
+
+	//state changed while drawing batches, to be restored afterward:
+	GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+	GLint depth_func = GL_LESS;
+	glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	GLint blend_src_rgb = GL_ONE, blend_dst_rgb = GL_ZERO, blend_src_alpha = GL_ONE, blend_dst_alpha = GL_ZERO;
+	glGetIntegerv(GL_BLEND_SRC_RGB, &blend_src_rgb);
+	glGetIntegerv(GL_BLEND_DST_RGB, &blend_dst_rgb);
+	glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend_src_alpha);
+	glGetIntegerv(GL_BLEND_DST_ALPHA, &blend_dst_alpha);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(color_texture_program->program);
+	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	glActiveTexture(GL_TEXTURE0);
+
+	//draw batches in the order they were started, one draw per atlas page:
+	for (size_t i = 0; i < batch_count; ++i) {
+		Batch const &batch = batches[i];
+
+		bool set_up = false;
+		for (uint32_t p = 0; p < batch.pages.size(); ++p) {
+			std::vector< Vertex > const &attribs = batch.pages[p];
+			if (attribs.empty()) continue;
+
+			if (!set_up) {
+				if (batch.depth_test) glEnable(GL_DEPTH_TEST);
+				else glDisable(GL_DEPTH_TEST);
+				glDepthFunc(batch.depth_func);
+				glUniformMatrix4fv(color_texture_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(batch.world_to_clip));
+				set_up = true;
+			}
+
+			GLuint quads = GLuint(attribs.size() / 4);
+			reserve_quad_indices(quads);
+			glBindVertexArray(vertex_buffer_for_color_texture_program); //(reserve_quad_indices may have unbound it)
+
+			size_t offset = vertex_stream().write(attribs.data(), attribs.size() * sizeof(attribs[0]), sizeof(attribs[0]));
+
+			glBindTexture(GL_TEXTURE_2D, batch.atlas->pages[p]);
+			glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(quads * 6), GL_UNSIGNED_INT, (GLbyte *)0, GLint(offset / sizeof(attribs[0])));
+		}
+	}
+	batch_count = 0;
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	if (depth_test) glEnable(GL_DEPTH_TEST);
+	else glDisable(GL_DEPTH_TEST);
+	glDepthFunc(depth_func);
+	if (!blend) glDisable(GL_BLEND);
+	glBlendFuncSeparate(blend_src_rgb, blend_dst_rgb, blend_src_alpha, blend_dst_alpha);
+
+	GL_ERRORS();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+ * Helper class for drawing sprites (images from a SpriteAtlas) -- e.g., HUD icons.
+ *
+ * Similar usage pattern to DrawLines:
+ *
+ * { //in a mode's draw function:
+ *     DrawSprites sprites(*hud_atlas, world_to_clip);
+ *     sprites.draw(heart, glm::vec2(-1.0f, 0.9f), glm::vec2(-0.9f, 1.0f));
+ * }
+ *
+ * Sprites from every DrawSprites made during a frame are collected into batches
+ *  (one per atlas, world_to_clip matrix, and depth test state), and drawn by
+ *  DrawSprites::flush() -- which main calls once the mode has drawn -- with one
+ *  draw per atlas page, alpha blended, from the same stream buffer as DrawLines.
+ *
+ */
+
+#include "SpriteAtlas.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+struct DrawSprites {
+	//Start drawing sprites from 'atlas'; will remember world_to_clip matrix:
+	// (and the current depth test state, which is restored when the batch is drawn)
+	DrawSprites(SpriteAtlas const &atlas, glm::mat4 const &world_to_clip);
+
+	//draw a sprite covering the rectangle from min to max (in the world's xy plane, at z = 0):
+	void draw(Sprite const &sprite, glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &tint = glm::u8vec4(0xff));
+
+	//draw a sprite covering the parallelogram with lower left corner 'corner' and sides x and y (in world space):
+	void draw(Sprite const &sprite, glm::vec3 const &corner, glm::vec3 const &x, glm::vec3 const &y, glm::u8vec4 const &tint = glm::u8vec4(0xff));
+
+	//Draw (push vertices to GPU) everything drawn by DrawSprites since the last flush:
+	// (call once per frame, after the mode draws; leaves depth test and blend state as it found them)
+	static void flush();
+
+
+	//vertices for ColorTextureProgram (four per sprite; drawn with a shared index buffer of quads):
+	struct Vertex {
+		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) : Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+		glm::vec3 Position;
+		glm::u8vec4 Color;
+		glm::vec2 TexCoord;
+	};
+
+	//sprites drawn during a frame from the same atlas, with the same world_to_clip and depth test state:
+	struct Batch {
+		SpriteAtlas const *atlas = nullptr;
+		glm::mat4 world_to_clip;
+		GLboolean depth_test = GL_FALSE;
+		GLint depth_func = GL_LESS;
+		std::vector< std::vector< Vertex > > pages; //vertices of sprites on each atlas page
+	};
+	Batch &batch;
+};
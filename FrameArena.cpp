@@ -0,0 +1,45 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t size_) : block(new char[size_]), size(size_) {
+	assert(size > 0);
+}
+
+void *FrameArena::allocate(size_t bytes, size_t alignment) {
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "alignment is a power of two");
+
+	//align the address itself, since the block's start is only as aligned as new char[] makes it:
+	uintptr_t base = reinterpret_cast< uintptr_t >(block.get());
+	size_t offset = size_t(((base + used + alignment - 1) & ~uintptr_t(alignment - 1)) - base);
+	if (offset + bytes <= size) {
+		used = offset + bytes;
+		return block.get() + offset;
+	}
+
+	//didn't fit; get it from the heap until the next reset makes the block bigger:
+	overflow.emplace_back(new char[bytes + alignment]);
+	overflow_bytes += bytes + alignment;
+	uintptr_t at = reinterpret_cast< uintptr_t >(overflow.back().get());
+	return reinterpret_cast< void * >((at + alignment - 1) & ~uintptr_t(alignment - 1));
+}
+
+void FrameArena::reset() {
+	if (!overflow.empty()) {
+		//make room for everything this frame needed (and some more, so slowly growing use doesn't overflow every frame):
+		size_t needed = used + overflow_bytes;
+		overflow.clear();
+		overflow_bytes = 0;
+		size = std::max(2 * size, needed + needed / 2);
+		block.reset(new char[size]);
+	}
+	used = 0;
+}
+
+FrameArena &frame_arena() {
+	//1MB is plenty for the HUD and a few thousand drawables' draw lists:
+	static FrameArena arena(1 << 20);
+	return arena;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+ * A FrameArena hands out memory that only needs to last until the end of the
+ *  frame (e.g., lists of things to draw, strings to lay out), by bumping a
+ *  pointer through one big block. Nothing is freed on its own; reset() --
+ *  which main calls at the start of every frame -- frees everything at once.
+ *
+ * Allocations that don't fit in the block come from the heap, and the next
+ *  reset() replaces the block with one big enough for the whole frame,
+ *  so frames that use about as much as the last one never touch the heap.
+ *
+ * FrameAllocator< T > lets standard containers use the frame arena:
+ *
+ * FrameVector< GLint > firsts; //std::vector< GLint, FrameAllocator< GLint > >
+ * FrameString label = "'"; //std::basic_string< char, ..., FrameAllocator< char > >
+ *
+ * (anything using these must be gone before the next reset(), so don't keep them in members or statics)
+ *
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct FrameArena {
+	//make an arena with a 'size' byte block:
+	explicit FrameArena(size_t size);
+
+	//(owns its blocks, so can't be copied)
+	FrameArena(FrameArena const &) = delete;
+	FrameArena &operator=(FrameArena const &) = delete;
+
+	//'bytes' bytes at a multiple of 'alignment' (a power of two), good until the next reset():
+	void *allocate(size_t bytes, size_t alignment);
+
+	//free everything allocated since the last reset:
+	// (if the block overflowed, replaces it with one that fits everything allocated since then)
+	void reset();
+
+	//----- internals -----
+	std::unique_ptr< char[] > block;
+	size_t size = 0;
+	size_t used = 0; //bytes of block used (including alignment padding)
+
+	//allocations that didn't fit in the block:
+	std::vector< std::unique_ptr< char[] > > overflow;
+	size_t overflow_bytes = 0;
+};
+
+//the arena for this frame's transient data (reset by main at the start of each frame):
+FrameArena &frame_arena();
+
+//allocator that takes memory from frame_arena() (and never gives it back; reset() does that):
+template< typename T >
+struct FrameAllocator {
+	using value_type = T;
+
+	FrameAllocator() = default;
+	template< typename U >
+	FrameAllocator(FrameAllocator< U > const &) { }
+
+	T *allocate(size_t n) {
+		return static_cast< T * >(frame_arena().allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T *, size_t) { }
+};
+
+template< typename T, typename U >
+bool operator==(FrameAllocator< T > const &, FrameAllocator< U > const &) { return true; }
+template< typename T, typename U >
+bool operator!=(FrameAllocator< T > const &, FrameAllocator< U > const &) { return false; }
+
+template< typename T >
+using FrameVector = std::vector< T, FrameAllocator< T > >;
+
+using FrameString = std::basic_string< char, std::char_traits< char >, FrameAllocator< char > >;
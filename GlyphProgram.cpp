@@ -0,0 +1,47 @@
+#include "GlyphProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+Load< GlyphProgram > glyph_program(LoadTagEarly, new_T< GlyphProgram >, "GlyphProgram");
+
+GlyphProgram::GlyphProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec2 Point;\n" //per-vertex
+		"in vec3 Anchor;\n" //per-instance...
+		"in vec3 X;\n"
+		"in vec3 Y;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(Anchor + Point.x * X + Point.y * Y, 1.0);\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	Point_vec2 = glGetAttribLocation(program, "Point");
+	Anchor_vec3 = glGetAttribLocation(program, "Anchor");
+	X_vec3 = glGetAttribLocation(program, "X");
+	Y_vec3 = glGetAttribLocation(program, "Y");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+}
+
+GlyphProgram::~GlyphProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
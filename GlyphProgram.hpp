@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GL.hpp"
+#include "Load.hpp"
+
+//Shader program that draws instances of line-font glyphs (used by DrawLines for text):
+// each vertex is a point on a glyph's outline, placed by its instance's anchor and x/y axes
+struct GlyphProgram {
+	GlyphProgram();
+	~GlyphProgram();
+
+	GLuint program = 0;
+	//Attribute (per-vertex variable) locations:
+	GLuint Point_vec2 = -1U;
+	//Attribute (per-instance variable) locations:
+	GLuint Anchor_vec3 = -1U;
+	GLuint X_vec3 = -1U;
+	GLuint Y_vec3 = -1U;
+	GLuint Color_vec4 = -1U;
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	//Textures:
+	// none
+};
+
+extern Load< GlyphProgram > glyph_program;
@@ -0,0 +1,229 @@
+#include "HotReload.hpp"
+
+#include "data_path.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+	struct Watch {
+		std::string path;
+		std::function< void() > on_change;
+		int64_t modified = 0; //(when polling modification times)
+	};
+
+	struct Watcher {
+		std::vector< Watch > watches;
+		#if defined(__linux__)
+		int fd = -1; //inotify instance
+		std::map< int, std::string > directories; //inotify watch descriptor -> directory (with trailing '/')
+		#else
+		std::chrono::steady_clock::time_point next_check = std::chrono::steady_clock::now();
+		#endif
+	};
+
+	Watcher &get_watcher() {
+		static Watcher watcher;
+		return watcher;
+	}
+
+	#if !defined(__linux__)
+	//modification time of a file (or 0 if it can't be read):
+	int64_t modified_time(std::string const &path) {
+		#if defined(_WIN32)
+		struct _stat64 info;
+		if (_stat64(path.c_str(), &info) != 0) return 0;
+		#else
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0) return 0;
+		#endif
+		return int64_t(info.st_mtime);
+	}
+	#endif
+}
+
+void watch_file(std::string const &path, std::function< void() > const &on_change) {
+	if (in_data_pack(path)) return; //(packed files don't change)
+
+	Watcher &watcher = get_watcher();
+
+	#if defined(__linux__)
+	//inotify watches directories, which catches files that are replaced (by renaming a new version over them) as well as rewritten:
+	if (watcher.fd == -1) {
+		watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (watcher.fd == -1) {
+			std::cerr << "WARNING: failed to start watching files (errno " << errno << "); hot reloading is off." << std::endl;
+			return;
+		}
+	}
+	size_t slash = path.rfind('/');
+	std::string directory = (slash == std::string::npos ? "./" : path.substr(0, slash + 1));
+	int wd = inotify_add_watch(watcher.fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (wd == -1) {
+		std::cerr << "WARNING: failed to watch '" << directory << "' (errno " << errno << "); '" << path << "' won't be reloaded." << std::endl;
+		return;
+	}
+	watcher.directories[wd] = directory;
+	std::string name = (slash == std::string::npos ? path : path.substr(slash + 1));
+	watcher.watches.emplace_back(Watch{directory + name, on_change});
+	#else
+	watcher.watches.emplace_back(Watch{path, on_change, modified_time(path)});
+	#endif
+}
+
+void poll_file_watches() {
+	Watcher &watcher = get_watcher();
+	if (watcher.watches.empty()) return;
+
+	//paths of files that changed (each once, even if written several times since the last poll):
+	std::vector< std::string > changed;
+
+	#if defined(__linux__)
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t got = read(watcher.fd, buffer, sizeof(buffer));
+		if (got <= 0) break; //(EAGAIN: no more events)
+		for (ssize_t at = 0; at < got; ) {
+			inotify_event const *event = reinterpret_cast< inotify_event const * >(buffer + at);
+			at += sizeof(inotify_event) + event->len;
+			auto directory = watcher.directories.find(event->wd);
+			if (event->len == 0 || directory == watcher.directories.end()) continue;
+			std::string path = directory->second + event->name; //(name is padded with '\0's)
+			if (std::find(changed.begin(), changed.end(), path) == changed.end()) changed.emplace_back(path);
+		}
+	}
+	#else
+	//(checking modification times means a trip to the file system per file, so not every frame)
+	auto now = std::chrono::steady_clock::now();
+	if (now < watcher.next_check) return;
+	watcher.next_check = now + std::chrono::milliseconds(500);
+	for (Watch &watch : watcher.watches) {
+		int64_t modified = modified_time(watch.path);
+		if (modified != 0 && modified != watch.modified) {
+			watch.modified = modified;
+			if (std::find(changed.begin(), changed.end(), watch.path) == changed.end()) changed.emplace_back(watch.path);
+		}
+	}
+	#endif
+
+	for (std::string const &path : changed) {
+		for (Watch const &watch : watcher.watches) {
+			if (watch.path != path) continue;
+			auto before = std::chrono::steady_clock::now();
+			try {
+				watch.on_change();
+			} catch (std::exception const &e) {
+				std::cerr << "WARNING: failed to reload '" << path << "': " << e.what() << std::endl;
+				continue;
+			}
+			auto after = std::chrono::steady_clock::now();
+			std::cout << "Reloaded '" << path << "' in " << std::chrono::duration< double, std::milli >(after - before).count() << " ms." << std::endl;
+		}
+	}
+}
+
+void patch_drawables(Scene &scene, MeshBuffer const &buffer, std::vector< MeshChange > const &changes) {
+	if (changes.empty()) return;
+
+	//changes by the vertex range they used to have:
+	std::map< std::tuple< GLenum, GLuint, GLuint >, Mesh const * > after;
+	for (MeshChange const &change : changes) {
+		after.emplace(std::make_tuple(change.before.type, change.before.start, change.before.count), &change.after);
+	}
+
+	for (Scene::Drawable &drawable : scene.drawables) {
+		Scene::Drawable::Pipeline &pipeline = drawable.pipeline;
+
+		//only drawables that use the buffer's storage can be using its meshes:
+		auto const &vaos = buffer.storage->vaos;
+		if (std::none_of(vaos.begin(), vaos.end(), [&](auto const &lv) { return lv.second == pipeline.vao; })) continue;
+
+		auto f = after.find(std::make_tuple(pipeline.type, pipeline.start, pipeline.count));
+		if (f == after.end()) continue;
+		Mesh const &mesh = *f->second;
+		pipeline.type = mesh.type;
+		pipeline.start = mesh.start;
+		pipeline.count = mesh.count;
+		pipeline.meshlets = mesh.meshlets;
+		pipeline.meshlet_count = mesh.meshlet_count;
+		pipeline.position_scale = mesh.position_scale;
+		pipeline.position_offset = mesh.position_offset;
+	}
+}
+
+bool apply_scene_changes(Scene &scene, CookedScene::Contents const &before, CookedScene::Contents const &after) {
+	auto name = [](CookedScene::Contents const &contents, uint32_t begin, uint32_t end) {
+		return std::string(contents.names.begin() + begin, contents.names.begin() + end);
+	};
+
+	//transforms are matched by order, so the hierarchy has to be the same:
+	if (before.transforms.size() != after.transforms.size() || scene.transforms.size() < after.transforms.size()) return false;
+	{
+		auto live = scene.transforms.begin();
+		for (size_t i = 0; i < after.transforms.size(); ++i, ++live) {
+			CookedScene::Transform const &a = before.transforms[i];
+			CookedScene::Transform const &b = after.transforms[i];
+			std::string b_name = name(after, b.name_begin, b.name_end);
+			if (a.parent != b.parent || name(before, a.name_begin, a.name_end) != b_name || live->name != b_name) return false;
+		}
+	}
+	//...and so do the cameras and lights:
+	auto same_transforms = [](auto const &a, auto const &b) {
+		if (a.size() != b.size()) return false;
+		for (size_t i = 0; i < a.size(); ++i) {
+			if (a[i].transform != b[i].transform) return false;
+		}
+		return true;
+	};
+	if (!same_transforms(before.cameras, after.cameras) || scene.cameras.size() < after.cameras.size()) return false;
+	if (!same_transforms(before.lights, after.lights) || scene.lights.size() < after.lights.size()) return false;
+
+	if (!same_transforms(before.drawables, after.drawables)) {
+		std::cerr << "WARNING: drawables in the scene changed; restart to see them." << std::endl;
+	}
+
+	//apply just what changed (so anything else the game has changed is left alone):
+	{
+		auto live = scene.transforms.begin();
+		for (size_t i = 0; i < after.transforms.size(); ++i, ++live) {
+			CookedScene::Transform const &a = before.transforms[i];
+			CookedScene::Transform const &b = after.transforms[i];
+			if (a.position != b.position) live->position = b.position;
+			if (a.rotation != b.rotation) live->rotation = b.rotation;
+			if (a.scale != b.scale) live->scale = b.scale;
+		}
+	}
+	{
+		auto live = scene.cameras.begin();
+		for (size_t i = 0; i < after.cameras.size(); ++i, ++live) {
+			CookedScene::Camera const &a = before.cameras[i];
+			CookedScene::Camera const &b = after.cameras[i];
+			if (a.fovy != b.fovy) live->fovy = b.fovy;
+			if (a.near != b.near) live->near = b.near;
+		}
+	}
+	{
+		auto live = scene.lights.begin();
+		for (size_t i = 0; i < after.lights.size(); ++i, ++live) {
+			CookedScene::Light const &a = before.lights[i];
+			CookedScene::Light const &b = after.lights[i];
+			if (a.type != b.type) live->type = Scene::Light::Type(b.type);
+			if (a.energy != b.energy) live->energy = b.energy;
+			if (a.spot_fov != b.spot_fov) live->spot_fov = b.spot_fov;
+		}
+	}
+	return true;
+}
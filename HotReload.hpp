@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+ * Hot reloading: apply changes to asset files while the game runs, without a restart.
+ *
+ * watch_file() registers a function to call when a file is rewritten;
+ *  main calls poll_file_watches() once per frame to run the functions of files that changed.
+ *  (On Linux, changes come from inotify; elsewhere, file modification times are checked twice a second.)
+ *
+ * Loaders use these to patch what they loaded in place:
+ *  - mesh files: MeshBuffer::reload (see Mesh.hpp) uploads only the meshes that changed,
+ *    and patch_drawables() points drawables at their new vertex ranges.
+ *  - scene files: apply_scene_changes() updates only the transforms, cameras, and lights
+ *    that differ between the old and new versions of the file.
+ *
+ */
+
+#include "Scene.hpp"
+#include "Mesh.hpp"
+#include "CookedScene.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+//call 'on_change' (from poll_file_watches) whenever the file at 'path' is rewritten:
+// (files found in the data pack can't change, so they aren't watched)
+void watch_file(std::string const &path, std::function< void() > const &on_change);
+
+//call the functions of watched files that were rewritten since the last call:
+// (errors thrown by these functions are reported rather than passed on, so a half-exported file doesn't end the game)
+void poll_file_watches();
+
+//update drawables with pipelines copied from meshes that MeshBuffer::reload changed:
+// (drawables are matched by VAO, primitive type, and vertex range)
+void patch_drawables(Scene &scene, MeshBuffer const &buffer, std::vector< MeshChange > const &changes);
+
+//apply the differences between two versions of a scene file to a scene loaded from it:
+// transforms, cameras, and lights from the file are matched with the first ones in the scene, in order
+//  (as Scene::load and copies of scenes leave them; things added afterward are left alone)
+// returns false, changing nothing, if the hierarchy changed (that needs a restart)
+bool apply_scene_changes(Scene &scene, CookedScene::Contents const &before, CookedScene::Contents const &after);
@@ -1,20 +1,133 @@
 #include "Load.hpp"
 
+#include "GL.hpp"
+
 #include <array>
 #include <list>
 #include <cassert>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+#if defined(_WIN32)
+#undef APIENTRY //(GL.hpp's definition; windows.h makes its own)
+#include <windows.h>
+#endif
 
 namespace {
-	std::array< std::list< std::function< void() > >, MaxLoadTag > &get_load_lists() {
-		static std::array< std::list< std::function< void() > >, MaxLoadTag > load_lists;
+	struct LoadFunction {
+		std::function< void() > fn;
+		LoadSite site;
+	};
+
+	std::array< std::list< LoadFunction >, MaxLoadTag > &get_load_lists() {
+		static std::array< std::list< LoadFunction >, MaxLoadTag > load_lists;
 		return load_lists;
 	}
+
+	std::vector< LoadProfile > &get_profiles() {
+		static std::vector< LoadProfile > profiles;
+		return profiles;
+	}
+
+	//processor time used by the process so far:
+	double cpu_ms() {
+		#if defined(_WIN32)
+		FILETIME creation, exit, kernel, user;
+		if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+		auto ticks = [](FILETIME const &t) { return (uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime; }; //100ns ticks
+		return (ticks(kernel) + ticks(user)) / 1.0e4;
+		#else
+		return std::clock() * (1000.0 / CLOCKS_PER_SEC);
+		#endif
+	}
+
+	//bytes read by the process so far (or -1 if there is no way to know):
+	int64_t bytes_read() {
+		#if defined(_WIN32)
+		IO_COUNTERS counters;
+		if (!GetProcessIoCounters(GetCurrentProcess(), &counters)) return -1;
+		return int64_t(counters.ReadTransferCount);
+		#elif defined(__linux__)
+		std::ifstream io("/proc/self/io");
+		std::string key;
+		int64_t value;
+		while (io >> key >> value) {
+			if (key == "rchar:") return value;
+		}
+		return -1;
+		#else
+		return -1;
+		#endif
+	}
+
+	//OpenGL objects alive right now, of each kind:
+	struct GLObjects {
+		int32_t buffers = 0;
+		int32_t textures = 0;
+		int32_t vertex_arrays = 0;
+		int32_t programs = 0;
+	};
+	GLObjects count_gl_objects() {
+		//names are checked with glIs*() from 1 up to the next name the driver would hand out,
+		// then on until a long run of unused names -- which covers drivers that count up
+		// (everything alive is below the next name) and drivers that reuse the lowest free name
+		// (everything alive is packed above it, short of a loader deleting hundreds in a row)
+		constexpr GLuint UnusedRun = 256;
+		auto count = [](GLuint next, auto is) -> int32_t {
+			int32_t alive = 0;
+			GLuint unused = 0;
+			for (GLuint name = 1; name <= next || unused < UnusedRun; ++name) {
+				if (is(name)) {
+					alive += 1;
+					unused = 0;
+				} else {
+					unused += 1;
+				}
+			}
+			return alive;
+		};
+
+		GLuint next = 0;
+		GLObjects objects;
+
+		glGenBuffers(1, &next);
+		glDeleteBuffers(1, &next);
+		objects.buffers = count(next, [](GLuint name) { return glIsBuffer(name) == GL_TRUE; });
+
+		glGenTextures(1, &next);
+		glDeleteTextures(1, &next);
+		objects.textures = count(next, [](GLuint name) { return glIsTexture(name) == GL_TRUE; });
+
+		glGenVertexArrays(1, &next);
+		glDeleteVertexArrays(1, &next);
+		objects.vertex_arrays = count(next, [](GLuint name) { return glIsVertexArray(name) == GL_TRUE; });
+
+		//(shaders share names with programs, but glIsProgram() is only true for programs)
+		next = glCreateProgram();
+		glDeleteProgram(next);
+		objects.programs = count(next, [](GLuint name) { return glIsProgram(name) == GL_TRUE; });
+
+		return objects;
+	}
+}
+
+std::string LoadProfile::name() const {
+	if (site.label) return site.label;
+	std::string file = site.file;
+	file = file.substr(file.find_last_of("/\\") + 1);
+	return file + ":" + std::to_string(site.line);
 }
 
-void add_load_function(LoadTag tag, std::function< void() > const &fn) {
+void add_load_function(LoadTag tag, std::function< void() > const &fn, LoadSite const &site) {
 	auto &load_lists = get_load_lists();
 	assert(tag < load_lists.size());
-	load_lists[tag].emplace_back(fn);
+	load_lists[tag].emplace_back(LoadFunction{fn, site});
 }
 
 void call_load_functions() {
@@ -22,11 +135,102 @@ void call_load_functions() {
 	assert(!has_been_called && "call_load_functions should only be called *once*");
 	has_been_called = true;
 
+	typedef std::chrono::steady_clock Clock;
+	auto ms = [](Clock::duration d) { return std::chrono::duration< double, std::milli >(d).count(); };
+	Clock::time_point begin = Clock::now();
+
 	auto &load_lists = get_load_lists();
-	for (auto &fn_list : load_lists) {
+	auto &profiles = get_profiles();
+	for (uint32_t tag = 0; tag < load_lists.size(); ++tag) {
+		auto &fn_list = load_lists[tag];
 		while (!fn_list.empty()) {
-			(*fn_list.begin())(); //call first function in the list
+			LoadFunction const &load = *fn_list.begin();
+
+			GLObjects objects_before = count_gl_objects();
+			int64_t read_before = bytes_read();
+			double cpu_before = cpu_ms();
+			Clock::time_point wall_before = Clock::now();
+
+			load.fn(); //call first function in the list
+
+			Clock::time_point wall_after = Clock::now();
+			double cpu_after = cpu_ms();
+			int64_t read_after = bytes_read();
+			GLObjects objects_after = count_gl_objects();
+
+			profiles.emplace_back();
+			LoadProfile &profile = profiles.back();
+			profile.site = load.site;
+			profile.tag = LoadTag(tag);
+			profile.start_ms = ms(wall_before - begin);
+			profile.wall_ms = ms(wall_after - wall_before);
+			profile.cpu_ms = cpu_after - cpu_before;
+			profile.bytes_read = (read_before >= 0 && read_after >= 0 ? read_after - read_before : -1);
+			profile.buffers = objects_after.buffers - objects_before.buffers;
+			profile.textures = objects_after.textures - objects_before.textures;
+			profile.vertex_arrays = objects_after.vertex_arrays - objects_before.vertex_arrays;
+			profile.programs = objects_after.programs - objects_before.programs;
+
 			fn_list.pop_front(); //remove from list
 		}
 	}
 }
+
+std::vector< LoadProfile > const &load_profiles() {
+	return get_profiles();
+}
+
+void print_load_report(std::ostream &out) {
+	std::vector< LoadProfile const * > sorted;
+	double total_ms = 0.0;
+	for (auto const &profile : load_profiles()) {
+		sorted.emplace_back(&profile);
+		total_ms += profile.wall_ms;
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](LoadProfile const *a, LoadProfile const *b) {
+		return a->wall_ms > b->wall_ms;
+	});
+
+	std::ostringstream report; //(so 'out's formatting flags are left alone)
+	report << std::fixed << std::setprecision(1);
+	report << "Loaded " << sorted.size() << " things in " << total_ms << " ms (slowest first):\n";
+	report << "   wall ms    cpu ms   read KiB  buf  tex  vao prog  name\n";
+	for (LoadProfile const *profile : sorted) {
+		report << std::setw(10) << profile->wall_ms << std::setw(10) << profile->cpu_ms;
+		if (profile->bytes_read >= 0) report << std::setw(11) << (profile->bytes_read / 1024.0);
+		else report << std::setw(11) << "?";
+		report << std::setw(5) << profile->buffers << std::setw(5) << profile->textures << std::setw(5) << profile->vertex_arrays << std::setw(5) << profile->programs;
+		report << "  " << profile->name() << "\n";
+	}
+	out << report.str() << std::flush;
+}
+
+void write_load_trace(std::string const &filename) {
+	auto quote = [](std::string const &str) {
+		std::string ret = "\"";
+		for (char c : str) {
+			if (c == '"' || c == '\\') ret += '\\';
+			if (uint8_t(c) < 0x20) ret += ' ';
+			else ret += c;
+		}
+		return ret + "\"";
+	};
+
+	std::ofstream out(filename, std::ios::binary);
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (auto const &profile : load_profiles()) {
+		if (!first) out << ",\n";
+		first = false;
+		//complete ('X') event; times are in microseconds:
+		out << "{\"name\":" << quote(profile.name()) << ",\"cat\":\"load\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+		out << ",\"ts\":" << profile.start_ms * 1000.0 << ",\"dur\":" << profile.wall_ms * 1000.0;
+		out << ",\"args\":{\"file\":" << quote(profile.site.file) << ",\"line\":" << profile.site.line << ",\"tag\":" << uint32_t(profile.tag);
+		out << ",\"cpu_ms\":" << profile.cpu_ms << ",\"bytes_read\":" << profile.bytes_read;
+		out << ",\"buffers\":" << profile.buffers << ",\"textures\":" << profile.textures << ",\"vertex_arrays\":" << profile.vertex_arrays << ",\"programs\":" << profile.programs;
+		out << "}}";
+	}
+	out << "\n]}\n";
+	if (!out) throw std::runtime_error("Failed to write load trace to '" + filename + "'.");
+}
@@ -20,10 +20,17 @@
  * These functions are grouped by 'tags', which allow some sequencing of calls.
  * (particularly, this is useful for loading large data blobs [e.g. Meshes] before looking up individual elements within them.)
  *
+ * call_load_functions() also measures what each function costs (time, bytes read, OpenGL objects left alive);
+ *  see load_profiles(), print_load_report(), and write_load_trace().
+ *
  */
 
 #include <functional>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
 
 enum LoadTag : uint32_t {
 	LoadTagEarly,
@@ -32,15 +39,58 @@ enum LoadTag : uint32_t {
 	MaxLoadTag //<-- just used to track # of load tags
 };
 
+//Where a load function was registered, for reports:
+// (Load<> fills in the file and line of its declaration, where the compiler supports it)
+struct LoadSite {
+	char const *label = nullptr; //(optional) name to use in reports; defaults to file:line
+	char const *file = "?";
+	uint32_t line = 0;
+};
+
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1926)
+#define LOAD_CALLER_FILE __builtin_FILE()
+#define LOAD_CALLER_LINE __builtin_LINE()
+#else
+#define LOAD_CALLER_FILE "?"
+#define LOAD_CALLER_LINE 0
+#endif
+
 //Add a function to an internal list of loading functions:
 // (only call *before* "call_load_functions()")
-void add_load_function(LoadTag tag, std::function< void() > const &fn);
+void add_load_function(LoadTag tag, std::function< void() > const &fn, LoadSite const &site = LoadSite());
 
 //Call all loading functions:
 // (loading functions may throw exceptions if they fail.)
 // (only call *once*)
 void call_load_functions();
 
+//What a load function cost, as measured by call_load_functions():
+struct LoadProfile {
+	LoadSite site;
+	LoadTag tag = LoadTagDefault;
+	double start_ms = 0.0; //when it started, from the start of call_load_functions()
+	double wall_ms = 0.0; //elapsed time
+	double cpu_ms = 0.0; //processor time used by the whole process (all threads)
+	int64_t bytes_read = -1; //bytes read from files (as counted by the OS; not including mapped files), or -1 if not known on this platform
+	//change in the number of live OpenGL objects (made minus deleted; temporaries, like shaders or a buffer replaced by a bigger one, don't count):
+	int32_t buffers = 0;
+	int32_t textures = 0;
+	int32_t vertex_arrays = 0;
+	int32_t programs = 0;
+
+	std::string name() const; //label, or file:line
+};
+
+//profiles of the load functions called so far, in call order:
+std::vector< LoadProfile > const &load_profiles();
+
+//print a table of load_profiles(), slowest first:
+void print_load_report(std::ostream &out);
+
+//write load_profiles() as a trace (Chrome trace event JSON; view in chrome://tracing or ui.perfetto.dev):
+// each load function is a span, with its measurements as arguments
+void write_load_trace(std::string const &filename);
+
 
 //work-around for MSVC not accepting this as a lambda:
 template< typename T >
@@ -49,13 +99,15 @@ T const *new_T() { return new T; }
 template< typename T >
 struct Load {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >) : value(nullptr) {
+	// (file and line default to where the Load< T > is declared; 'label' names it in reports)
+	Load(LoadTag tag, const std::function< T const *() > &load_fn = new_T< T >, char const *label = nullptr,
+		char const *file = LOAD_CALLER_FILE, uint32_t line = LOAD_CALLER_LINE) : value(nullptr) {
 		add_load_function(tag, [this,load_fn](){
 			this->value = load_fn();
 			if (!(this->value)) {
 				throw std::runtime_error("Loading failed.");
 			}
-		});
+		}, LoadSite{label, file, line});
 	}
 
 	//Make a "Load< T >" behave like a "T const *":
@@ -73,8 +125,9 @@ struct Load {
 template< >
 struct Load< void > {
 	//Constructing a Load< T > adds the passed function to the list of functions to call:
-	Load( LoadTag tag, const std::function< void() > &load_fn) {
-		add_load_function(tag, load_fn);
+	Load( LoadTag tag, const std::function< void() > &load_fn, char const *label = nullptr,
+		char const *file = LOAD_CALLER_FILE, uint32_t line = LOAD_CALLER_LINE) {
+		add_load_function(tag, load_fn, LoadSite{label, file, line});
 	}
 };
 
@@ -1,5 +1,5 @@
 #include "Mesh.hpp"
-#include "read_write_chunk.hpp"
+#include "ChunkFile.hpp"
 
 #include <glm/glm.hpp>
 
@@ -8,15 +8,245 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <set>
 #include <cstddef>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <tuple>
 
-MeshBuffer::MeshBuffer(std::string const &filename) {
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MESH_BOUNDS_SSE
+#endif
+
+namespace {
+	//per-mesh bounds, as stored in the optional 'bnd0' chunk (one entry per index entry):
+	struct BoundsEntry {
+		glm::vec3 min, max; //axis-aligned bounding box
+		glm::vec3 center; //bounding sphere
+		float radius;
+	};
+	static_assert(sizeof(BoundsEntry) == 4*3+4*3+4*3+4, "Bounds entry should be packed");
+
+	//attribute reflection for a program:
+	struct ProgramAttributes {
+		GLint locations[4]; //locations of Position, Normal, Color, TexCoord (-1 if not in program)
+		std::vector< std::pair< std::string, GLint > > active; //all active attributes (name, location)
+	};
+
+	//reflection is queried once per program and cached:
+	// (assumes programs aren't deleted, so names aren't reused)
+	ProgramAttributes const &program_attributes(GLuint program) {
+		static std::map< GLuint, ProgramAttributes > cache;
+		auto f = cache.find(program);
+		if (f != cache.end()) return f->second;
+
+		ProgramAttributes attributes;
+		char const *names[4] = {"Position", "Normal", "Color", "TexCoord"};
+		for (uint32_t a = 0; a < 4; ++a) {
+			attributes.locations[a] = glGetAttribLocation(program, names[a]);
+		}
+
+		GLint active = 0;
+		glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &active);
+		assert(active >= 0 && "Doesn't makes sense to have negative active attributes.");
+		for (GLuint i = 0; i < GLuint(active); ++i) {
+			GLchar name[100];
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveAttrib(program, i, 100, NULL, &size, &type, name);
+			name[99] = '\0';
+			attributes.active.emplace_back(name, glGetAttribLocation(program, name));
+		}
+
+		return cache.emplace(program, attributes).first->second;
+	}
+
+	//run fn(0) ... fn(count-1) spread over the available hardware threads:
+	template< typename F >
+	void parallel_for(size_t count, F const &fn) {
+		size_t workers = std::min< size_t >(count, std::max(1U, std::thread::hardware_concurrency()));
+		if (workers <= 1) {
+			for (size_t i = 0; i < count; ++i) fn(i);
+			return;
+		}
+		std::vector< std::thread > threads;
+		for (size_t w = 0; w < workers; ++w) {
+			threads.emplace_back([&,w](){
+				for (size_t i = w; i < count; i += workers) fn(i);
+			});
+		}
+		for (auto &thread : threads) thread.join();
+	}
+
+	//compute bounds for vertex ranges [first,second) of float positions spaced 'stride' bytes apart:
+	// (used for files without a 'bnd0' chunk; note that the SSE path reads 16 bytes at each position)
+	std::vector< BoundsEntry > compute_bounds(char const *positions, size_t stride, std::vector< std::pair< uint32_t, uint32_t > > const &ranges) {
+		//split ranges into similarly-sized jobs so big meshes don't end up on one thread:
+		constexpr uint32_t JobVertices = 1 << 16;
+		struct Job {
+			uint32_t range;
+			uint32_t begin, end;
+			glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+			glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
+			float radius2 = 0.0f;
+		};
+		std::vector< Job > jobs;
+		for (uint32_t r = 0; r < ranges.size(); ++r) {
+			for (uint32_t begin = ranges[r].first; begin < ranges[r].second; begin += std::min(JobVertices, ranges[r].second - begin)) {
+				jobs.emplace_back();
+				jobs.back().range = r;
+				jobs.back().begin = begin;
+				jobs.back().end = begin + std::min(JobVertices, ranges[r].second - begin);
+			}
+		}
+		auto position = [&](uint32_t v) {
+			return reinterpret_cast< float const * >(positions + size_t(v) * stride);
+		};
+
+		//first pass: bounding boxes:
+		parallel_for(jobs.size(), [&](size_t j){
+			Job &job = jobs[j];
+			#ifdef MESH_BOUNDS_SSE
+			__m128 lo = _mm_set1_ps( std::numeric_limits< float >::infinity());
+			__m128 hi = _mm_set1_ps(-std::numeric_limits< float >::infinity());
+			for (uint32_t v = job.begin; v < job.end; ++v) {
+				__m128 p = _mm_loadu_ps(position(v));
+				lo = _mm_min_ps(lo, p);
+				hi = _mm_max_ps(hi, p);
+			}
+			float out[4];
+			_mm_storeu_ps(out, lo);
+			job.min = glm::vec3(out[0], out[1], out[2]);
+			_mm_storeu_ps(out, hi);
+			job.max = glm::vec3(out[0], out[1], out[2]);
+			#else
+			for (uint32_t v = job.begin; v < job.end; ++v) {
+				glm::vec3 p(position(v)[0], position(v)[1], position(v)[2]);
+				job.min = glm::min(job.min, p);
+				job.max = glm::max(job.max, p);
+			}
+			#endif
+		});
+
+		std::vector< BoundsEntry > bounds(ranges.size());
+		for (auto &b : bounds) {
+			b.min = glm::vec3( std::numeric_limits< float >::infinity());
+			b.max = glm::vec3(-std::numeric_limits< float >::infinity());
+		}
+		for (Job const &job : jobs) {
+			bounds[job.range].min = glm::min(bounds[job.range].min, job.min);
+			bounds[job.range].max = glm::max(bounds[job.range].max, job.max);
+		}
+		for (uint32_t r = 0; r < ranges.size(); ++r) {
+			bounds[r].center = (ranges[r].first < ranges[r].second ? 0.5f * (bounds[r].min + bounds[r].max) : glm::vec3(0.0f));
+			bounds[r].radius = 0.0f;
+		}
+
+		//second pass: bounding sphere radius around box center:
+		parallel_for(jobs.size(), [&](size_t j){
+			Job &job = jobs[j];
+			glm::vec3 c = bounds[job.range].center;
+			uint32_t v = job.begin;
+			#ifdef MESH_BOUNDS_SSE
+			//four vertices at a time, transposed so lanes hold x/y/z of different vertices:
+			__m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+			__m128 best = _mm_setzero_ps();
+			for (; v + 4 <= job.end; v += 4) {
+				__m128 x = _mm_loadu_ps(position(v+0));
+				__m128 y = _mm_loadu_ps(position(v+1));
+				__m128 z = _mm_loadu_ps(position(v+2));
+				__m128 w = _mm_loadu_ps(position(v+3));
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+				x = _mm_sub_ps(x, cx);
+				y = _mm_sub_ps(y, cy);
+				z = _mm_sub_ps(z, cz);
+				__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+				best = _mm_max_ps(best, d2);
+			}
+			float out[4];
+			_mm_storeu_ps(out, best);
+			job.radius2 = std::max(std::max(out[0], out[1]), std::max(out[2], out[3]));
+			#endif
+			for (; v < job.end; ++v) {
+				glm::vec3 d = glm::vec3(position(v)[0], position(v)[1], position(v)[2]) - c;
+				job.radius2 = std::max(job.radius2, glm::dot(d, d));
+			}
+		});
+
+		for (Job const &job : jobs) {
+			bounds[job.range].radius = std::max(bounds[job.range].radius, std::sqrt(job.radius2));
+		}
+		return bounds;
+	}
+}
+
+bool MeshFormat::operator<(MeshFormat const &other) const {
+	auto key = [](MeshFormat const &f) {
+		auto attrib = [](Attrib const &a) {
+			return std::make_tuple(a.size, a.type, a.normalized, a.stride, a.offset);
+		};
+		return std::make_tuple(f.stride, attrib(f.Position), attrib(f.Normal), attrib(f.Color), attrib(f.TexCoord));
+	};
+	return key(*this) < key(other);
+}
+
+MeshStorage::MeshStorage(MeshFormat const &format_) : format(format_) {
 	glGenBuffers(1, &buffer);
+}
+
+GLintptr MeshStorage::allocate(GLsizeiptr size) {
+	assert(format.stride && size % format.stride == 0);
 
-	std::ifstream file(filename, std::ios::binary);
+	//grow buffer if needed, copying over the meshes already stored:
+	if (used + size > capacity) {
+		GLsizeiptr grown_capacity = std::max(used + size, 2 * capacity);
+		GLuint grown = 0;
+		glGenBuffers(1, &grown);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, grown_capacity, nullptr, GL_STATIC_DRAW);
+		if (used) {
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+		buffer = grown;
+		capacity = grown_capacity;
+
+		//point existing VAOs at the new buffer:
+		MeshFormat::Attrib const *attribs[4] = {&format.Position, &format.Normal, &format.Color, &format.TexCoord};
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		for (auto const &lv : vaos) {
+			glBindVertexArray(lv.second);
+			for (uint32_t a = 0; a < 4; ++a) {
+				if (lv.first[a] == -1) continue;
+				MeshFormat::Attrib const &attrib = *attribs[a];
+				glVertexAttribPointer(lv.first[a], attrib.size, attrib.type, attrib.normalized, attrib.stride, (GLbyte *)0 + attrib.offset);
+			}
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	GLintptr offset = used;
+	used += size;
+	return offset;
+}
+
+std::shared_ptr< MeshStorage > MeshPool::storage_for(MeshFormat const &format) {
+	auto &storage = storages[format];
+	if (!storage) storage = std::make_shared< MeshStorage >(format);
+	return storage;
+}
+
+MeshBuffer::MeshBuffer(std::string const &filename, Residency residency, MeshPool *pool) {
+	std::shared_ptr< ChunkFile > file_ptr = std::make_shared< ChunkFile >(filename);
+	ChunkFile &file = *file_ptr;
 
 	GLuint total = 0;
+	bool quantized = false; //are positions stored quantized (and need a 'qnt0' chunk)?
 
 	struct Vertex {
 		glm::vec3 Position;
@@ -27,28 +257,94 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 	static_assert(sizeof(Vertex) == 3*4+3*4+4*1+2*4, "Vertex is packed.");
 	std::vector< Vertex > data;
 
-	//read + upload data chunk:
+	//compact vertex format:
+	// Position is quantized to 16 bits within the mesh's bounds (w is padding),
+	// Normal is packed as signed 10-10-10-2, and TexCoord is stored as half floats:
+	struct CompactVertex {
+		uint16_t Position[4];
+		uint32_t Normal;
+		glm::u8vec4 Color;
+		uint16_t TexCoord[2];
+	};
+	static_assert(sizeof(CompactVertex) == 4*2+4+4*1+2*2, "CompactVertex is packed.");
+
+	//find data chunk:
+	std::string magic;
 	if (filename.size() >= 5 && filename.substr(filename.size()-5) == ".pnct") {
-		read_chunk(file, "pnct", &data);
+		magic = "pnct";
+	} else if (filename.size() >= 5 && filename.substr(filename.size()-5) == ".pncq") {
+		magic = "pncq";
+		quantized = true;
+	} else {
+		throw std::runtime_error("Unknown file type '" + filename + "'");
+	}
+	size_t stride = (quantized ? sizeof(CompactVertex) : sizeof(Vertex));
 
-		//upload data:
-		glBindBuffer(GL_ARRAY_BUFFER, buffer);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(Vertex), data.data(), GL_STATIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	ChunkFile::Chunk const *vertices = file.find(magic);
+	if (!vertices) {
+		throw std::runtime_error("File '" + filename + "' has no '" + magic + "' chunk");
+	}
+	if (vertices->size % stride != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+	if (vertices->size / stride > std::numeric_limits< GLuint >::max()) {
+		throw std::runtime_error("File '" + filename + "' has too many vertices");
+	}
+	total = GLuint(vertices->size / stride); //store total for later checks on index
 
-		total = GLuint(data.size()); //store total for later checks on index
+	//describe vertex format:
+	MeshFormat format;
+	if (quantized) {
+		// (Position decodes to [0,1]^3; the per-mesh position_scale/offset maps it back to object space)
+		format.Position = MeshFormat::Attrib(3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), offsetof(CompactVertex, Position));
+		format.Normal = MeshFormat::Attrib(4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex), offsetof(CompactVertex, Normal));
+		format.Color = MeshFormat::Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CompactVertex), offsetof(CompactVertex, Color));
+		format.TexCoord = MeshFormat::Attrib(2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), offsetof(CompactVertex, TexCoord));
+	} else {
+		format.Position = MeshFormat::Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
+		format.Normal = MeshFormat::Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Normal));
+		format.Color = MeshFormat::Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), offsetof(Vertex, Color));
+		format.TexCoord = MeshFormat::Attrib(2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, TexCoord));
+	}
+	format.stride = GLsizei(stride);
+	storage = (pool ? pool->storage_for(format) : std::make_shared< MeshStorage >(format));
 
-		//store attrib locations:
-		Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
-		Normal = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Normal));
-		Color = Attrib(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), offsetof(Vertex, Color));
-		TexCoord = Attrib(2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, TexCoord));
+	//read + upload data chunk:
+	GLuint base = 0; //index of this file's first vertex in storage
+	if (residency == Residency::OnLookup) {
+		//meshes are uploaded by make_resident()...
+		if (!quantized && !file.find("bnd0")) {
+			//...but float positions are still needed to compute bounds (below):
+			file.read("pnct", &data);
+		}
+		source = file_ptr;
+		source_magic = magic;
 	} else {
-		throw std::runtime_error("Unknown file type '" + filename + "'");
+		GLintptr offset = storage->allocate(GLsizeiptr(vertices->size));
+		if (uint64_t(offset) / stride + total > std::numeric_limits< GLuint >::max()) {
+			throw std::runtime_error("Too many vertices in mesh storage to add '" + filename + "'");
+		}
+		base = GLuint(offset / stride);
+		resident_bytes = vertices->size;
+
+		glBindBuffer(GL_ARRAY_BUFFER, storage->buffer);
+		if (!quantized && !file.find("bnd0")) {
+			//float positions are needed to compute bounds (below), so read all the data:
+			file.read("pnct", &data);
+			glBufferSubData(GL_ARRAY_BUFFER, offset, GLsizeiptr(vertices->size), data.data());
+		} else {
+			//nothing to compute on the CPU, so stream data to the buffer without holding it in memory all at once:
+			constexpr size_t UploadBatch = 4 << 20; //bytes
+			file.read_batches< char >(*vertices, UploadBatch, [&](char const *bytes, size_t count) {
+				glBufferSubData(GL_ARRAY_BUFFER, offset, GLsizeiptr(count), bytes);
+				offset += GLintptr(count);
+			});
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
 	std::vector< char > strings;
-	read_chunk(file, "str0", &strings);
+	file.read("str0", &strings);
 
 	{ //read index chunk, add to meshes:
 		struct IndexEntry {
@@ -58,93 +354,413 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		static_assert(sizeof(IndexEntry) == 16, "Index entry should be packed");
 
 		std::vector< IndexEntry > index;
-		read_chunk(file, "idx0", &index);
+		file.read("idx0", &index);
+
+		//compact files also carry the quantization range of each index entry:
+		struct QuantizationEntry {
+			glm::vec3 min, max;
+		};
+		static_assert(sizeof(QuantizationEntry) == 4*3+4*3, "Quantization entry should be packed");
+
+		std::vector< QuantizationEntry > ranges;
+		if (quantized) {
+			file.read("qnt0", &ranges);
+			if (ranges.size() != index.size()) {
+				throw std::runtime_error("quantization chunk does not match index chunk");
+			}
+		}
 
-		for (auto const &entry : index) {
+		for (IndexEntry const &entry : index) {
 			if (!(entry.name_begin <= entry.name_end && entry.name_end <= strings.size())) {
 				throw std::runtime_error("index entry has out-of-range name begin/end");
 			}
 			if (!(entry.vertex_begin <= entry.vertex_end && entry.vertex_end <= total)) {
 				throw std::runtime_error("index entry has out-of-range vertex start/count");
 			}
+		}
+
+		//bounds are precomputed by the exporter (or 'asset-tool bounds') in newer files:
+		std::vector< BoundsEntry > bounds;
+		if (file.find("bnd0")) {
+			file.read("bnd0", &bounds);
+			if (bounds.size() != index.size()) {
+				throw std::runtime_error("bounds chunk does not match index chunk");
+			}
+		} else if (!quantized) {
+			std::vector< std::pair< uint32_t, uint32_t > > vertex_ranges;
+			vertex_ranges.reserve(index.size());
+			for (IndexEntry const &entry : index) {
+				vertex_ranges.emplace_back(entry.vertex_begin, entry.vertex_end);
+			}
+			bounds = compute_bounds(reinterpret_cast< char const * >(data.data()) + offsetof(Vertex, Position), sizeof(Vertex), vertex_ranges);
+		}
+
+		std::vector< uint32_t > entry_id(index.size(), -1U); //ID of the mesh made from each index entry
+
+		for (uint32_t i = 0; i < index.size(); ++i) {
+			IndexEntry const &entry = index[i];
 			std::string name(&strings[0] + entry.name_begin, &strings[0] + entry.name_end);
 			Mesh mesh;
 			mesh.type = GL_TRIANGLES;
-			mesh.start = entry.vertex_begin;
+			mesh.start = base + entry.vertex_begin;
 			mesh.count = entry.vertex_end - entry.vertex_begin;
-			for (uint32_t v = entry.vertex_begin; v < entry.vertex_end; ++v) {
-				mesh.min = glm::min(mesh.min, data[v].Position);
-				mesh.max = glm::max(mesh.max, data[v].Position);
+			if (quantized) {
+				//quantized positions span exactly the quantization range:
+				mesh.position_offset = ranges[i].min;
+				mesh.position_scale = ranges[i].max - ranges[i].min;
+			}
+			if (mesh.count) {
+				if (!bounds.empty()) {
+					mesh.min = bounds[i].min;
+					mesh.max = bounds[i].max;
+					mesh.sphere_center = bounds[i].center;
+					mesh.sphere_radius = bounds[i].radius;
+				} else {
+					//quantized file without 'bnd0'; use the box around the quantization range:
+					mesh.min = ranges[i].min;
+					mesh.max = ranges[i].max;
+					mesh.sphere_center = 0.5f * (mesh.min + mesh.max);
+					mesh.sphere_radius = 0.5f * glm::length(mesh.max - mesh.min);
+				}
+			}
+			uint64_t hash = mesh_name_hash(name);
+			uint32_t existing = find_id(hash);
+			if (existing != -1U) {
+				if (names[existing] == name) {
+					std::cerr << "WARNING: mesh name '" + name + "' in filename '" + filename + "' collides with existing mesh." << std::endl;
+				} else {
+					std::cerr << "WARNING: mesh name '" + name + "' in filename '" + filename + "' has the same hash as '" + names[existing] + "'; it can't be looked up." << std::endl;
+				}
+				continue;
 			}
-			bool inserted = meshes.insert(std::make_pair(name, mesh)).second;
-			if (!inserted) {
-				std::cerr << "WARNING: mesh name '" + name + "' in filename '" + filename + "' collides with existing mesh." << std::endl;
+			uint32_t id = uint32_t(meshes.size());
+			meshes.emplace_back(mesh);
+			names.emplace_back(name);
+			entry_id[i] = id;
+			if (residency == Residency::OnLookup && mesh.count) {
+				//not resident yet; make_resident() will set its start:
+				meshes.back().start = 0;
+				pending.emplace_back(entry.vertex_begin);
+				pending_count += 1;
+			} else {
+				pending.emplace_back(-1U);
+			}
+
+			add_slot(Slot{hash, id});
+		}
+
+		//clusters are made offline by 'asset-tool meshlets' (if at all):
+		if (file.find("mlt0")) {
+			struct MeshletEntry {
+				uint32_t entry; //index entry of the mesh this cluster belongs to
+				Meshlet meshlet;
+			};
+			static_assert(sizeof(MeshletEntry) == 4 + sizeof(Meshlet), "Meshlet entry should be packed");
+
+			std::vector< MeshletEntry > entries;
+			file.read("mlt0", &entries);
+
+			//each mesh's clusters must be consecutive and cover its vertices in order:
+			std::vector< uint32_t > first_meshlet(meshes.size(), -1U);
+			std::vector< GLuint > covered(meshes.size(), 0);
+			meshlets.reserve(entries.size());
+			for (size_t e = 0; e < entries.size(); ++e) {
+				MeshletEntry const &me = entries[e];
+				if (me.entry >= index.size() || (e > 0 && me.entry < entries[e-1].entry)) {
+					throw std::runtime_error("meshlet chunk does not match index chunk");
+				}
+				uint32_t id = entry_id[me.entry];
+				if (id == -1U) continue; //(index entry was skipped above)
+				GLuint count = index[me.entry].vertex_end - index[me.entry].vertex_begin;
+				if (me.meshlet.first != covered[id] || me.meshlet.count > count - covered[id]) {
+					throw std::runtime_error("meshlet entry has out-of-range vertex first/count");
+				}
+				if (first_meshlet[id] == -1U) first_meshlet[id] = uint32_t(meshlets.size());
+				covered[id] += me.meshlet.count;
+				meshes[id].meshlet_count += 1;
+				meshlets.emplace_back(me.meshlet);
+			}
+			//(pointers are set once 'meshlets' is done growing)
+			for (uint32_t id = 0; id < meshes.size(); ++id) {
+				if (first_meshlet[id] == -1U) continue;
+				if (covered[id] != meshes[id].count) {
+					throw std::runtime_error("meshlets of mesh '" + names[id] + "' do not cover all of its vertices");
+				}
+				meshes[id].meshlets = meshlets.data() + first_meshlet[id];
 			}
 		}
 	}
+	if (pending_count == 0) source.reset();
 
-	if (file.peek() != EOF) {
-		std::cerr << "WARNING: trailing data in mesh file '" << filename << "'" << std::endl;
+	for (auto const &chunk : file.chunks) {
+		if (chunk.magic != "pnct" && chunk.magic != "pncq" && chunk.magic != "str0" && chunk.magic != "idx0" && chunk.magic != "qnt0" && chunk.magic != "bnd0" && chunk.magic != "mlt0") {
+			std::cerr << "WARNING: unexpected chunk '" << chunk.magic << "' in mesh file '" << filename << "'" << std::endl;
+		}
 	}
 
 	/* //DEBUG:
 	std::cout << "File '" << filename << "' contained meshes";
-	for (auto const &m : meshes) {
-		if (&m.second == &meshes.rbegin()->second && meshes.size() > 1) std::cout << " and";
-		std::cout << " '" << m.first << "'";
-		if (&m.second != &meshes.rbegin()->second) std::cout << ",";
+	for (uint32_t id = 0; id < names.size(); ++id) {
+		if (id + 1 == names.size() && names.size() > 1) std::cout << " and";
+		std::cout << " '" << names[id] << "'";
+		if (id + 1 != names.size()) std::cout << ",";
 	}
 	std::cout << std::endl;
 	*/
 }
 
 const Mesh &MeshBuffer::lookup(std::string const &name) const {
-	auto f = meshes.find(name);
-	if (f == meshes.end()) {
+	return meshes[lookup_id(name)];
+}
+
+uint32_t MeshBuffer::lookup_id(std::string const &name) const {
+	uint32_t id = find_id(mesh_name_hash(name));
+	if (id == -1U || names[id] != name) {
 		throw std::runtime_error("Looking up mesh '" + name + "' that doesn't exist.");
 	}
-	return f->second;
+	if (pending_count) make_resident(id);
+	return id;
+}
+
+uint32_t MeshBuffer::lookup_id(uint64_t name_hash) const {
+	uint32_t id = find_id(name_hash);
+	if (id == -1U) {
+		throw std::runtime_error("Looking up mesh with hash " + std::to_string(name_hash) + " that doesn't exist.");
+	}
+	if (pending_count) make_resident(id);
+	return id;
+}
+
+uint32_t MeshBuffer::find_id(uint64_t name_hash) const {
+	if (table.empty()) return -1U;
+	size_t mask = table.size() - 1;
+	for (size_t i = size_t(name_hash) & mask; table[i].id != -1U; i = (i + 1) & mask) {
+		if (table[i].hash == name_hash) return table[i].id;
+	}
+	return -1U;
+}
+
+void MeshBuffer::add_slot(Slot const &slot) {
+	//(re)build table at twice the size whenever it gets half full:
+	if (table.size() < 2 * meshes.size()) {
+		std::vector< Slot > old;
+		old.swap(table);
+		table.resize(std::max< size_t >(16, 2 * old.size()));
+		for (Slot const &existing : old) {
+			if (existing.id != -1U) insert_slot(existing);
+		}
+	}
+	insert_slot(slot);
+}
+
+void MeshBuffer::insert_slot(Slot const &slot) {
+	assert(!table.empty() && (table.size() & (table.size() - 1)) == 0);
+	size_t mask = table.size() - 1;
+	size_t i = size_t(slot.hash) & mask;
+	while (table[i].id != -1U) i = (i + 1) & mask;
+	table[i] = slot;
+}
+
+void MeshBuffer::make_resident(uint32_t id) const {
+	if (pending[id] == -1U) return; //already resident
+
+	Mesh &mesh = meshes[id];
+	GLsizei stride = storage->format.stride;
+	GLsizeiptr size = GLsizeiptr(mesh.count) * stride;
+
+	//append the mesh's vertices to storage:
+	std::vector< char > bytes(static_cast< size_t >(size));
+	source->read_range(*source->find(source_magic), uint64_t(pending[id]) * stride, uint64_t(size), bytes.data());
+	GLintptr offset = storage->allocate(size);
+	glBindBuffer(GL_ARRAY_BUFFER, storage->buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, bytes.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	mesh.start = GLuint(offset / stride);
+	resident_bytes += uint64_t(size);
+
+	pending[id] = -1U;
+	pending_count -= 1;
+	if (pending_count == 0) source.reset(); //every mesh is resident; no need to keep the file open
+}
+
+std::vector< MeshChange > MeshBuffer::reload(std::string const &filename) {
+	//read the new version of the file (uploading nothing yet):
+	MeshBuffer fresh(filename, Residency::OnLookup);
+	glDeleteBuffers(1, &fresh.storage->buffer); //(meshes go in this buffer's storage instead)
+	fresh.storage->buffer = 0;
+	if (fresh.storage->format < storage->format || storage->format < fresh.storage->format) {
+		throw std::runtime_error("Vertex format of '" + filename + "' changed; it can't be reloaded.");
+	}
+	GLsizei stride = storage->format.stride;
+
+	std::vector< Mesh > before = meshes;
+	std::vector< bool > was_resident(meshes.size());
+	for (uint32_t id = 0; id < meshes.size(); ++id) {
+		was_resident[id] = (pending[id] == -1U);
+	}
+	std::vector< bool > in_file(meshes.size(), false);
+
+	std::vector< char > bytes; //vertices of a mesh in the new file
+	std::vector< char > old_bytes; //vertices of the same mesh in storage
+	auto upload = [&](GLintptr offset) {
+		glBindBuffer(GL_ARRAY_BUFFER, storage->buffer);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, GLsizeiptr(bytes.size()), bytes.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	};
+
+	for (uint32_t f = 0; f < fresh.meshes.size(); ++f) {
+		std::string const &name = fresh.names[f];
+		Mesh after = fresh.meshes[f]; //(bounds, decoding, and meshlets from the new file; start is set below)
+
+		uint64_t hash = mesh_name_hash(name);
+		uint32_t id = find_id(hash);
+		bool existed = (id != -1U);
+		if (existed && names[id] != name) {
+			std::cerr << "WARNING: mesh name '" + name + "' in filename '" + filename + "' has the same hash as '" + names[id] + "'; it can't be looked up." << std::endl;
+			continue;
+		}
+		if (!existed) {
+			//new mesh; add it:
+			id = uint32_t(meshes.size());
+			meshes.emplace_back();
+			names.emplace_back(name);
+			pending.emplace_back(-1U);
+			add_slot(Slot{hash, id});
+		} else {
+			in_file[id] = true;
+		}
+		Mesh &mesh = meshes[id];
+
+		if (pending[id] != -1U) {
+			//not resident, so nothing to upload; make_resident() will read it from the new file:
+			pending[id] = (after.count ? fresh.pending[f] : -1U);
+			after.start = 0;
+			mesh = after;
+			continue;
+		}
+
+		bytes.resize(size_t(after.count) * stride);
+		if (after.count) {
+			fresh.source->read_range(*fresh.source->find(fresh.source_magic), uint64_t(fresh.pending[f]) * stride, bytes.size(), bytes.data());
+		}
+
+		bool same = false;
+		if (existed && after.count == mesh.count) {
+			//compare with the vertices already on the GPU:
+			old_bytes.resize(bytes.size());
+			if (!old_bytes.empty()) {
+				glBindBuffer(GL_ARRAY_BUFFER, storage->buffer);
+				glGetBufferSubData(GL_ARRAY_BUFFER, GLintptr(mesh.start) * stride, GLsizeiptr(old_bytes.size()), old_bytes.data());
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+			same = (old_bytes == bytes);
+		}
+
+		if (same || after.count == 0) {
+			after.start = (after.count ? mesh.start : 0);
+		} else if (existed && after.count <= mesh.count) {
+			//fits where the old version was:
+			upload(GLintptr(mesh.start) * stride);
+			after.start = mesh.start;
+		} else {
+			//grew (or is new); append to storage:
+			GLintptr offset = storage->allocate(GLsizeiptr(bytes.size()));
+			upload(offset);
+			after.start = GLuint(offset / stride);
+			resident_bytes += bytes.size();
+		}
+		mesh = after;
+	}
+
+	//meshes no longer in the file keep their old vertices (if they have any):
+	for (uint32_t id = 0; id < before.size(); ++id) {
+		if (in_file[id]) continue;
+		std::cerr << "WARNING: mesh '" << names[id] << "' is no longer in '" << filename << "'; keeping the old version." << std::endl;
+		if (pending[id] != -1U) {
+			//(can't be read from the new file)
+			pending[id] = -1U;
+			meshes[id].count = 0;
+		}
+	}
+
+	//meshes point into the new file's clusters now:
+	// (the old ones are kept, since copies of meshes may still point to them)
+	retired_meshlets.emplace_back();
+	retired_meshlets.back().swap(meshlets);
+	meshlets.swap(fresh.meshlets);
+
+	//meshes that aren't resident yet will come from the new file:
+	pending_count = uint32_t(std::count_if(pending.begin(), pending.end(), [](GLuint p) { return p != -1U; }));
+	if (pending_count) source = fresh.source;
+	else source.reset();
+
+	std::vector< MeshChange > changes;
+	for (uint32_t id = 0; id < before.size(); ++id) {
+		if (!was_resident[id]) continue; //(nothing could have copied it)
+		Mesh const &a = before[id];
+		Mesh const &b = meshes[id];
+		if (a.type != b.type || a.start != b.start || a.count != b.count
+		 || a.meshlets != b.meshlets || a.meshlet_count != b.meshlet_count
+		 || a.position_scale != b.position_scale || a.position_offset != b.position_offset) {
+			changes.emplace_back(MeshChange{a, b});
+		}
+	}
+	return changes;
+}
+
+MeshBuffer::ResidencyStats MeshBuffer::residency_stats() const {
+	ResidencyStats stats;
+	stats.total_meshes = uint32_t(meshes.size());
+	stats.resident_meshes = uint32_t(meshes.size()) - pending_count;
+	stats.resident_bytes = resident_bytes;
+	for (uint32_t id = 0; id < meshes.size(); ++id) {
+		if (pending[id] != -1U) stats.unused_bytes += uint64_t(meshes[id].count) * storage->format.stride;
+	}
+	stats.buffer_bytes = uint64_t(storage->capacity);
+	return stats;
 }
 
 GLuint MeshBuffer::make_vao_for_program(GLuint program) const {
+	return storage->make_vao_for_program(program);
+}
+
+GLuint MeshStorage::make_vao_for_program(GLuint program) {
+	ProgramAttributes const &attributes = program_attributes(program);
+
+	//the VAO only depends on where this format's attributes are bound:
+	MeshFormat::Attrib const *attribs[4] = {&format.Position, &format.Normal, &format.Color, &format.TexCoord};
+	AttribLocations locations;
+	for (uint32_t a = 0; a < 4; ++a) {
+		locations[a] = (attribs[a]->size == 0 ? -1 : attributes.locations[a]); //don't bind empty attribs
+	}
+
+	//Check that all active attributes will be bound:
+	for (auto const &active : attributes.active) {
+		if (std::find(locations.begin(), locations.end(), active.second) == locations.end()) {
+			throw std::runtime_error("ERROR: active attribute '" + active.first + "' in program is not bound.");
+		}
+	}
+
+	//programs with the same layout share a VAO:
+	auto existing = vaos.find(locations);
+	if (existing != vaos.end()) return existing->second;
+
 	//create a new vertex array object:
 	GLuint vao = 0;
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
-	//Try to bind all attributes in this buffer:
-	std::set< GLuint > bound;
 	glBindBuffer(GL_ARRAY_BUFFER, buffer);
-	auto bind_attribute = [&](char const *name, MeshBuffer::Attrib const &attrib) {
-		if (attrib.size == 0) return; //don't bind empty attribs
-		GLint location = glGetAttribLocation(program, name);
-		if (location == -1) return; //can't bind missing attribs
-		glVertexAttribPointer(location, attrib.size, attrib.type, attrib.normalized, attrib.stride, (GLbyte *)0 + attrib.offset);
-		glEnableVertexAttribArray(location);
-		bound.insert(location);
-	};
-	bind_attribute("Position", Position);
-	bind_attribute("Normal", Normal);
-	bind_attribute("Color", Color);
-	bind_attribute("TexCoord", TexCoord);
+	for (uint32_t a = 0; a < 4; ++a) {
+		if (locations[a] == -1) continue;
+		MeshFormat::Attrib const &attrib = *attribs[a];
+		glVertexAttribPointer(locations[a], attrib.size, attrib.type, attrib.normalized, attrib.stride, (GLbyte *)0 + attrib.offset);
+		glEnableVertexAttribArray(locations[a]);
+	}
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
-	//Check that all active attributes were bound:
-	GLint active = 0;
-	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &active);
-	assert(active >= 0 && "Doesn't makes sense to have negative active attributes.");
-	for (GLuint i = 0; i < GLuint(active); ++i) {
-		GLchar name[100];
-		GLint size = 0;
-		GLenum type = 0;
-		glGetActiveAttrib(program, i, 100, NULL, &size, &type, name);
-		name[99] = '\0';
-		GLint location = glGetAttribLocation(program, name);
-		if (!bound.count(GLuint(location))) {
-			throw std::runtime_error("ERROR: active attribute '" + std::string(name) + "' in program is not bound.");
-		}
-	}
-
+	vaos.emplace(locations, vao);
 	return vao;
 }
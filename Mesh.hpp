@@ -6,15 +6,46 @@
  * A "MeshBuffer" holds a collection of such meshes (loaded from a file) in
  *  a single OpenGL array buffer. Individual meshes can be looked up by name
  *  using the MeshBuffer::lookup() function.
+ * Meshes also have compact IDs (indices into MeshBuffer::meshes), from
+ *  MeshBuffer::lookup_id(), for code that wants to skip name lookups.
+ * Several MeshBuffers can share a "MeshPool", which puts all their meshes
+ *  (of the same vertex format) into one buffer with one VAO per program.
  *
  */
 
 #include "GL.hpp"
+#include "mesh_name_hash.hpp"
 #include <glm/glm.hpp>
+#include <array>
+#include <list>
 #include <map>
 #include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
 
+struct ChunkFile;
+
+
+//A cluster of (about 128) consecutive triangles of a mesh, with bounds for culling:
+// (clusters are made offline by 'asset-tool meshlets' and stored in the 'mlt0' chunk)
+struct Meshlet {
+	GLuint first = 0; //index of first vertex, relative to Mesh::start
+	GLuint count = 0; //count of vertices
+
+	//bounding sphere (object space):
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+
+	//normal cone; every triangle faces away from eye positions where
+	// dot(center - eye, cone_axis) >= cone_cutoff * length(center - eye) + radius
+	// (cone_cutoff is 1 for clusters that can't be culled this way)
+	glm::vec3 cone_axis = glm::vec3(0.0f, 0.0f, 1.0f);
+	float cone_cutoff = 1.0f;
+};
+static_assert(sizeof(Meshlet) == 4*2+4*3+4+4*3+4, "Meshlet is packed.");
 
 struct Mesh {
 	//Meshes are vertex ranges (and primitive types) in their MeshBuffer:
@@ -27,30 +58,31 @@ struct Mesh {
 	//useful for debug visualization and (perhaps, eventually) collision detection:
 	glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
 	glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
-};
-
-struct MeshBuffer {
-	//construct from a file:
-	// note: will throw if file fails to read.
-	MeshBuffer(std::string const &filename);
-
-	//look up a particular mesh by name:
-	// note: will throw if mesh not found.
-	const Mesh &lookup(std::string const &name) const;
-	
-	//build a vertex array object that links this vbo to attributes to a program:
-	// note: will throw if program defines attributes not contained in this buffer
-	GLuint make_vao_for_program(GLuint program) const;
+	//Bounding sphere (contains all vertices):
+	glm::vec3 sphere_center = glm::vec3(0.0f);
+	float sphere_radius = 0.0f;
 
-	//This is the OpenGL vertex buffer object containing the mesh data:
-	GLuint buffer = 0;
+	//Position decoding for quantized (compact) meshes:
+	// object-space position = position_offset + position_scale * Position
+	// (identity for meshes stored with float positions; copy these into Drawable::Pipeline)
+	glm::vec3 position_scale = glm::vec3(1.0f);
+	glm::vec3 position_offset = glm::vec3(0.0f);
 
-	//-- internals ---
+	//Clusters covering [start, start+count) in order, if the file has them (else meshlet_count is 0):
+	// (points into MeshBuffer::meshlets; copy these into Drawable::Pipeline to cull clusters when drawing)
+	Meshlet const *meshlets = nullptr;
+	uint32_t meshlet_count = 0;
+};
 
-	//used by the lookup() function:
-	std::map< std::string, Mesh > meshes;
+//A mesh that MeshBuffer::reload changed, before and after:
+// (so copies of it, e.g. in Drawable::Pipelines, can be updated; see HotReload.hpp)
+struct MeshChange {
+	Mesh before;
+	Mesh after;
+};
 
-	//These 'Attrib' structures describe the location of various attributes within the buffer (in exactly format wanted by glVertexAttribPointer). They are set when the file is loaded and are used by the "make_vao_for_program" call:
+//Describes the location of various attributes within a vertex buffer (in exactly the format wanted by glVertexAttribPointer):
+struct MeshFormat {
 	struct Attrib {
 		GLint size = 0;
 		GLenum type = 0;
@@ -67,4 +99,125 @@ struct MeshBuffer {
 	Attrib Normal;
 	Attrib Color;
 	Attrib TexCoord;
+
+	GLsizei stride = 0; //size of one vertex
+
+	//(ordering, so formats can be used as map keys)
+	bool operator<(MeshFormat const &other) const;
+};
+
+//A vertex buffer holding meshes of one format, possibly from several MeshBuffers:
+// (it grows as meshes are added; VAOs made with make_vao_for_program follow it)
+struct MeshStorage {
+	explicit MeshStorage(MeshFormat const &format);
+
+	MeshFormat format;
+
+	//reserve 'size' bytes (a multiple of format.stride) at the end of the buffer, growing it if needed:
+	// returns the offset of the reserved bytes; fill them with glBufferSubData
+	GLintptr allocate(GLsizeiptr size);
+
+	//vertex array object that links 'buffer' to the attributes of a program:
+	// (programs that put this format's attributes at the same locations share a VAO)
+	// note: will throw if program defines attributes not contained in this format
+	GLuint make_vao_for_program(GLuint program);
+
+	GLuint buffer = 0; //(replaced when the buffer grows)
+	GLsizeiptr used = 0; //bytes holding meshes
+	GLsizeiptr capacity = 0; //allocated bytes
+
+	//VAOs created by make_vao_for_program, keyed by the locations their attributes are bound to:
+	// (also used to point them at a new 'buffer')
+	typedef std::array< GLint, 4 > AttribLocations; //Position, Normal, Color, TexCoord (-1 if not bound)
+	std::map< AttribLocations, GLuint > vaos;
+};
+
+//A shared set of MeshStorage, one per vertex format:
+// pass it to several MeshBuffers so their meshes end up in the same buffers,
+// and can be drawn with the same VAO (e.g., so draws can be sorted and batched across files)
+struct MeshPool {
+	std::shared_ptr< MeshStorage > storage_for(MeshFormat const &format);
+
+	std::map< MeshFormat, std::shared_ptr< MeshStorage > > storages;
+};
+
+struct MeshBuffer {
+	//when mesh vertex data gets uploaded to the GPU:
+	enum class Residency {
+		All, //every mesh, when the file is loaded
+		OnLookup, //each mesh the first time it is looked up (names and bounds are still loaded up front)
+	};
+
+	//construct from a file:
+	// '.pnct' files hold 32-byte float vertices,
+	// '.pncq' files hold 20-byte quantized vertices (see Mesh::position_scale/offset)
+	// meshes go in this buffer's own storage, or in the shared storage of 'pool' (if given)
+	// note: will throw if file fails to read.
+	MeshBuffer(std::string const &filename, Residency residency = Residency::All, MeshPool *pool = nullptr);
+
+	//look up a particular mesh by name:
+	// (with Residency::OnLookup, this uploads the mesh if it isn't resident yet)
+	// note: will throw if mesh not found.
+	const Mesh &lookup(std::string const &name) const;
+
+	//look up the compact ID of a mesh by name or by mesh_name_hash(name):
+	// (meshes[id] can be used directly afterward; it is resident)
+	// note: will throw if mesh not found.
+	uint32_t lookup_id(std::string const &name) const;
+	uint32_t lookup_id(uint64_t name_hash) const;
+	
+	//re-read the file this buffer was loaded from (after it changed), keeping mesh IDs:
+	// only meshes whose vertices changed are uploaded again (in place, if they didn't grow); new meshes are added;
+	// meshes no longer in the file keep their old vertices
+	// returns the meshes whose drawing parameters (type, start, count, meshlets, position decoding) changed
+	// note: will throw if the file fails to read or its vertex format changed (leaving the buffer as it was)
+	std::vector< MeshChange > reload(std::string const &filename);
+
+	//get the vertex array object that links this buffer's storage to attributes of a program:
+	// (shared by all MeshBuffers with the same storage)
+	// note: will throw if program defines attributes not contained in this buffer
+	GLuint make_vao_for_program(GLuint program) const;
+
+	//This is where the mesh data lives (storage->buffer is the OpenGL vertex buffer object):
+	std::shared_ptr< MeshStorage > storage;
+
+	//how much vertex data is on the GPU:
+	struct ResidencyStats {
+		uint32_t resident_meshes = 0;
+		uint32_t total_meshes = 0;
+		uint64_t resident_bytes = 0; //vertex data uploaded to storage by this MeshBuffer
+		uint64_t unused_bytes = 0; //vertex data of meshes that have not been uploaded
+		uint64_t buffer_bytes = 0; //allocated size of storage (which may be shared)
+	};
+	ResidencyStats residency_stats() const;
+
+	//-- internals ---
+
+	//meshes and their names, indexed by ID:
+	// (mutable since lookup() may make meshes resident)
+	mutable std::vector< Mesh > meshes;
+	std::vector< std::string > names;
+
+	//clusters of all meshes (each Mesh points to its own range):
+	std::vector< Meshlet > meshlets;
+	//clusters from before each reload (kept so copies of old Mesh::meshlets pointers stay valid):
+	std::list< std::vector< Meshlet > > retired_meshlets;
+
+	//used by the lookup functions; open addressing with linear probing, power-of-two size, at most half full:
+	struct Slot {
+		uint64_t hash = 0;
+		uint32_t id = -1U; //-1U for empty slots
+	};
+	std::vector< Slot > table;
+	uint32_t find_id(uint64_t name_hash) const; //-1U if not found
+	void add_slot(Slot const &slot); //(grows the table as needed)
+	void insert_slot(Slot const &slot);
+
+	//state for Residency::OnLookup:
+	mutable std::shared_ptr< ChunkFile > source; //vertex data file, open until all meshes are resident
+	std::string source_magic; //name of vertex data chunk in 'source'
+	mutable std::vector< GLuint > pending; //per ID: first vertex in 'source', or -1U if resident
+	mutable uint32_t pending_count = 0;
+	mutable uint64_t resident_bytes = 0;
+	void make_resident(uint32_t id) const;
 };
@@ -0,0 +1,205 @@
+#include "Pack.hpp"
+
+#include "read_write_chunk.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Pack::Pack(std::string const &filename_) : filename(filename_) {
+	//map the whole file (the index is read in place, and so are uncompressed entries):
+	#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open '" + filename + "' for reading.");
+	}
+	LARGE_INTEGER size;
+	HANDLE map = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+		map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	CloseHandle(file);
+	if (map == NULL) {
+		throw std::runtime_error("Failed to map pack '" + filename + "'.");
+	}
+	mapping = reinterpret_cast< char const * >(MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(map); //(the view keeps the mapping alive)
+	if (!mapping) {
+		throw std::runtime_error("Failed to map pack '" + filename + "'.");
+	}
+	mapping_size = uint64_t(size.QuadPart);
+	#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		throw std::runtime_error("Failed to open '" + filename + "' for reading.");
+	}
+	struct stat info;
+	void *mapped = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		throw std::runtime_error("Failed to map pack '" + filename + "'.");
+	}
+	//most of the pack will be read at startup, so start reading all of it (in order) now:
+	madvise(mapped, size_t(info.st_size), MADV_WILLNEED);
+	mapping = reinterpret_cast< char const * >(mapped);
+	mapping_size = uint64_t(info.st_size);
+	#endif
+
+	try {
+		auto bad = [&](std::string const &what) {
+			throw std::runtime_error("pack '" + filename + "' " + what);
+		};
+
+		if (mapping_size < sizeof(Header)) bad("is too small to hold a header");
+		header = reinterpret_cast< Header const * >(mapping);
+		if (std::memcmp(header->magic, Header().magic, 4) != 0) bad("does not start with 'pak0'");
+		if (header->version != Version) bad("has unknown version " + std::to_string(header->version));
+
+		uint64_t index_size = sizeof(Header) + uint64_t(header->entry_count) * sizeof(Entry) + header->names_size;
+		if (index_size > mapping_size) bad("has an index that extends past the end of the file");
+		entries = reinterpret_cast< Entry const * >(mapping + sizeof(Header));
+		names = reinterpret_cast< char const * >(entries + header->entry_count);
+
+		for (uint32_t i = 0; i < header->entry_count; ++i) {
+			Entry const &entry = entries[i];
+			if (!(entry.name_begin <= entry.name_end && entry.name_end <= header->names_size)) {
+				bad("has an entry with invalid name indices");
+			}
+			if (i > 0 && !(name(entries[i-1]) < name(entry))) {
+				bad("has entries that are not sorted by name");
+			}
+			if (entry.flags & ~uint32_t(ChunkFlagCompressed)) bad("entry '" + name(entry) + "' uses unknown flags");
+			if (!(entry.flags & ChunkFlagCompressed) && entry.stored_size != entry.size) {
+				bad("entry '" + name(entry) + "' is uncompressed but has mismatched sizes");
+			}
+			if (entry.offset < index_size || entry.offset > mapping_size || entry.stored_size > mapping_size - entry.offset) {
+				bad("entry '" + name(entry) + "' extends outside of the file");
+			}
+		}
+	} catch (...) {
+		//(the destructor won't run if the constructor throws)
+		#if defined(_WIN32)
+		UnmapViewOfFile(mapping);
+		#else
+		munmap(const_cast< char * >(mapping), size_t(mapping_size));
+		#endif
+		throw;
+	}
+}
+
+Pack::~Pack() {
+	#if defined(_WIN32)
+	UnmapViewOfFile(mapping);
+	#else
+	munmap(const_cast< char * >(mapping), size_t(mapping_size));
+	#endif
+}
+
+Pack::Entry const *Pack::find(std::string const &name_) const {
+	Entry const *begin = entries;
+	Entry const *end = entries + header->entry_count;
+	Entry const *found = std::lower_bound(begin, end, name_, [this](Entry const &entry, std::string const &key) {
+		return key.compare(0, std::string::npos, names + entry.name_begin, entry.name_end - entry.name_begin) > 0;
+	});
+	if (found != end && name_.compare(0, std::string::npos, names + found->name_begin, found->name_end - found->name_begin) == 0) {
+		return found;
+	}
+	return nullptr;
+}
+
+char const *Pack::data(Entry const &entry) const {
+	if (entry.flags & ChunkFlagCompressed) return nullptr;
+	return mapping + entry.offset;
+}
+
+void Pack::read(Entry const &entry, void *to) const {
+	ChunkInfo info;
+	info.magic = name(entry); //(for error messages)
+	info.flags = entry.flags;
+	info.size = entry.size;
+	info.stored_size = entry.stored_size;
+	decode_chunk_data(info, mapping + entry.offset, to);
+}
+
+void Pack::write(std::string const &filename, std::vector< std::pair< std::string, std::string > > const &files_, bool compress) {
+	//entries are stored in name order:
+	std::vector< std::pair< std::string, std::string > > files = files_;
+	std::sort(files.begin(), files.end());
+	for (size_t i = 1; i < files.size(); ++i) {
+		if (files[i-1].first == files[i].first) {
+			throw std::runtime_error("More than one file would be stored as '" + files[i].first + "' in pack '" + filename + "'.");
+		}
+	}
+
+	Header header;
+	std::vector< Entry > entries;
+	std::vector< char > names;
+	entries.reserve(files.size());
+	for (auto const &file : files) {
+		entries.emplace_back(Entry());
+		Entry &entry = entries.back();
+		entry.name_begin = uint32_t(names.size());
+		names.insert(names.end(), file.first.begin(), file.first.end());
+		entry.name_end = uint32_t(names.size());
+	}
+	header.entry_count = uint32_t(entries.size());
+	header.names_size = uint32_t(names.size());
+
+	auto aligned = [](uint64_t offset) {
+		return (offset + Alignment - 1) / Alignment * Alignment;
+	};
+
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) throw std::runtime_error("Failed to open '" + filename + "' for writing.");
+
+	auto write_index = [&]() {
+		out.write(reinterpret_cast< char const * >(&header), sizeof(header));
+		out.write(reinterpret_cast< char const * >(entries.data()), entries.size() * sizeof(Entry));
+		out.write(names.data(), names.size());
+	};
+
+	//(the index is written again once the entries' offsets are known)
+	write_index();
+	uint64_t at = sizeof(Header) + entries.size() * sizeof(Entry) + names.size();
+	std::vector< char > padding(Alignment, '\0');
+
+	for (size_t i = 0; i < files.size(); ++i) {
+		std::ifstream in(files[i].second, std::ios::binary);
+		if (!in) throw std::runtime_error("Failed to open '" + files[i].second + "' for reading.");
+		std::vector< char > data((std::istreambuf_iterator< char >(in)), std::istreambuf_iterator< char >());
+
+		Entry &entry = entries[i];
+		entry.size = data.size();
+		if (compress) {
+			std::vector< char > stored = encode_chunk_data(data.data(), data.size());
+			if (stored.size() < data.size()) {
+				entry.flags = ChunkFlagCompressed;
+				data = std::move(stored);
+			}
+		}
+		entry.stored_size = data.size();
+
+		entry.offset = aligned(at);
+		out.write(padding.data(), std::streamsize(entry.offset - at));
+		out.write(data.data(), std::streamsize(data.size()));
+		at = entry.offset + entry.stored_size;
+	}
+
+	out.seekp(0);
+	write_index();
+	if (!out) throw std::runtime_error("Failed to write pack '" + filename + "'.");
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+ * A Pack is many data files stored in one file (written by pack-tool),
+ *  so the game can map one file at startup instead of opening and seeking
+ *  around in each of its data files.
+ *
+ * Layout:
+ *  Header
+ *  Entry[entry_count] <-- sorted by name (so lookups can binary search)
+ *  char[names_size] <-- entry names (paths relative to the data directory, with '/' separators)
+ *  (entry data, each starting at a multiple of Alignment)
+ *
+ * Entries may be stored compressed, in the block format of compressed chunks
+ *  (see read_write_chunk.hpp); uncompressed entries can be used in place.
+ *
+ * data_path.hpp looks up files in the data pack before looking on disk.
+ *
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+
+struct Pack {
+	enum : uint32_t { Version = 1, Alignment = 4096 };
+
+	struct Header {
+		char magic[4] = {'p', 'a', 'k', '0'};
+		uint32_t version = Version;
+		uint32_t entry_count = 0;
+		uint32_t names_size = 0;
+	};
+	static_assert(sizeof(Header) == 4 + 4 + 4 + 4, "Header is packed.");
+
+	struct Entry {
+		uint32_t name_begin, name_end; //range in names
+		uint32_t flags; //ChunkFlagCompressed, or 0
+		uint32_t reserved;
+		uint64_t offset; //of the stored data, from the start of the pack
+		uint64_t size; //size of the file
+		uint64_t stored_size; //size of the data stored in the pack
+	};
+	static_assert(sizeof(Entry) == 4 + 4 + 4 + 4 + 8 + 8 + 8, "Entry is packed.");
+
+	//map 'filename' and check its index:
+	// throws if the file can't be opened or is malformed
+	explicit Pack(std::string const &filename);
+	~Pack();
+
+	//(owns a mapping, so can't be copied)
+	Pack(Pack const &) = delete;
+	Pack &operator=(Pack const &) = delete;
+
+	//entry with the given name (or nullptr if there isn't one):
+	Entry const *find(std::string const &name) const;
+
+	std::string name(Entry const &entry) const {
+		return std::string(names + entry.name_begin, names + entry.name_end);
+	}
+
+	//data of an uncompressed entry, in place in the mapping (or nullptr if the entry is compressed):
+	char const *data(Entry const &entry) const;
+
+	//decode an entry's data into 'to', which must have room for entry.size bytes:
+	void read(Entry const &entry, void *to) const;
+
+	//write a pack holding 'files' (pairs of name in the pack, path to read the file from):
+	// if 'compress' is set, entries are stored compressed when that makes them smaller
+	static void write(std::string const &filename, std::vector< std::pair< std::string, std::string > > const &files, bool compress);
+
+	std::string filename;
+
+	//index (pointers into the mapping):
+	Header const *header = nullptr;
+	Entry const *entries = nullptr;
+	char const *names = nullptr;
+
+	//-- internals ---
+	char const *mapping = nullptr;
+	uint64_t mapping_size = 0;
+};
@@ -1595,5 +1595,57 @@ namespace {
 		0.357675f, 0.546999f, 0.357675f, 0.546999f, 0.380799f, 0.530776f,
 		0.380799f, 0.530776f, 0.407815f, 0.504100f
 	};
+	constexpr const uint32_t font_first_nodes[256] = {
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, 0, 1, 2, 3,
+		4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+		16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27,
+		28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39,
+		40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,
+		52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63,
+		64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75,
+		76, 77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87,
+		88, 89, 90, 91, 92, 93, 94, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U, -1U,
+		-1U, -1U, -1U, -1U
+	};
+	constexpr const PathFont::Node font_nodes[95] = {
+		{ 0, 95, 95 }, { 1, 95, 95 }, { 2, 95, 95 }, { 3, 95, 95 }, { 4, 95, 95 }, { 5, 95, 95 },
+		{ 6, 95, 95 }, { 7, 95, 95 }, { 8, 95, 95 }, { 9, 95, 95 }, { 10, 95, 95 }, { 11, 95, 95 },
+		{ 12, 95, 95 }, { 13, 95, 95 }, { 14, 95, 95 }, { 15, 95, 95 }, { 16, 95, 95 }, { 17, 95, 95 },
+		{ 18, 95, 95 }, { 19, 95, 95 }, { 20, 95, 95 }, { 21, 95, 95 }, { 22, 95, 95 }, { 23, 95, 95 },
+		{ 24, 95, 95 }, { 25, 95, 95 }, { 26, 95, 95 }, { 27, 95, 95 }, { 28, 95, 95 }, { 29, 95, 95 },
+		{ 30, 95, 95 }, { 31, 95, 95 }, { 32, 95, 95 }, { 33, 95, 95 }, { 34, 95, 95 }, { 35, 95, 95 },
+		{ 36, 95, 95 }, { 37, 95, 95 }, { 38, 95, 95 }, { 39, 95, 95 }, { 40, 95, 95 }, { 41, 95, 95 },
+		{ 42, 95, 95 }, { 43, 95, 95 }, { 44, 95, 95 }, { 45, 95, 95 }, { 46, 95, 95 }, { 47, 95, 95 },
+		{ 48, 95, 95 }, { 49, 95, 95 }, { 50, 95, 95 }, { 51, 95, 95 }, { 52, 95, 95 }, { 53, 95, 95 },
+		{ 54, 95, 95 }, { 55, 95, 95 }, { 56, 95, 95 }, { 57, 95, 95 }, { 58, 95, 95 }, { 59, 95, 95 },
+		{ 60, 95, 95 }, { 61, 95, 95 }, { 62, 95, 95 }, { 63, 95, 95 }, { 64, 95, 95 }, { 65, 95, 95 },
+		{ 66, 95, 95 }, { 67, 95, 95 }, { 68, 95, 95 }, { 69, 95, 95 }, { 70, 95, 95 }, { 71, 95, 95 },
+		{ 72, 95, 95 }, { 73, 95, 95 }, { 74, 95, 95 }, { 75, 95, 95 }, { 76, 95, 95 }, { 77, 95, 95 },
+		{ 78, 95, 95 }, { 79, 95, 95 }, { 80, 95, 95 }, { 81, 95, 95 }, { 82, 95, 95 }, { 83, 95, 95 },
+		{ 84, 95, 95 }, { 85, 95, 95 }, { 86, 95, 95 }, { 87, 95, 95 }, { 88, 95, 95 }, { 89, 95, 95 },
+		{ 90, 95, 95 }, { 91, 95, 95 }, { 92, 95, 95 }, { 93, 95, 95 }, { 94, 95, 95 }
+	};
+	constexpr const uint8_t font_node_chars[95] = {
+		32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43,
+		44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55,
+		56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67,
+		68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79,
+		80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91,
+		92, 93, 94, 95, 96, 97, 98, 99, 100, 101, 102, 103,
+		104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115,
+		116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126
+	};
 }
-PathFont PathFont::font(font_glyphs, font_glyph_widths, font_glyph_char_starts, font_chars, font_glyph_coord_starts, font_coords);
+PathFont PathFont::font(font_glyphs, font_glyph_widths, font_glyph_char_starts, font_chars, font_glyph_coord_starts, font_coords, font_first_nodes, font_nodes, font_node_chars);
@@ -3,22 +3,28 @@
 
 #include "PathFont.hpp"
 
-#include <iostream>
+uint32_t PathFont::match(char const *begin, char const *end, uint32_t *length) const {
+	uint32_t glyph = -1U;
+	*length = 0;
+	if (begin == end) return glyph;
 
-PathFont::PathFont(uint32_t glyphs_,
-	const float *glyph_widths_,
-	const uint32_t *glyph_char_starts_, const uint8_t *chars_,
-	const uint32_t *glyph_coord_starts_, const float *coords_
-	) : glyphs(glyphs_),
-		glyph_widths(glyph_widths_),
-		glyph_char_starts(glyph_char_starts_), chars(chars_),
-		glyph_coord_starts(glyph_coord_starts_), coords(coords_) {
-
-	for (uint32_t i = 0; i < glyphs; ++i) {
-		std::string str(reinterpret_cast< const char * >(chars + glyph_char_starts[i]), reinterpret_cast< const char * >(chars + glyph_char_starts[i+1]));
-		auto res = glyph_map.insert(std::make_pair(str, i));
-		if (!res.second) {
-			std::cerr << "WARNING: ignoring duplicate glyph for '" << str << "'." << std::endl;
+	uint32_t n = first_nodes[uint8_t(*begin)];
+	for (uint32_t matched = 1; n != -1U; ++matched) {
+		if (nodes[n].glyph != -1U) {
+			glyph = nodes[n].glyph;
+			*length = matched;
+		}
+		if (begin + matched == end) break;
+		//step to the child for the next character (there are few, so search them in order):
+		uint8_t c = uint8_t(begin[matched]);
+		uint32_t child = -1U;
+		for (uint32_t i = nodes[n].children_begin; i < nodes[n].children_end; ++i) {
+			if (node_chars[i] == c) {
+				child = i;
+				break;
+			}
 		}
+		n = child;
 	}
+	return glyph;
 }
@@ -10,17 +10,24 @@
 
 #include <glm/glm.hpp>
 
-#include <string>
-#include <vector>
-#include <map>
+#include <cstdint>
 
 struct PathFont {
+	struct Node;
+
 	//meant to be intitialized with some pointers to constant data:
-	PathFont(uint32_t glyphs,
-		const float *glyph_widths,
-		const uint32_t *glyph_char_starts, const uint8_t *chars,
-		const uint32_t *glyph_coord_starts, const float *coords
-		);
+	// (constexpr, so fonts with constant tables -- like the default font -- need no code run at startup)
+	constexpr PathFont(uint32_t glyphs_,
+		const float *glyph_widths_,
+		const uint32_t *glyph_char_starts_, const uint8_t *chars_,
+		const uint32_t *glyph_coord_starts_, const float *coords_,
+		const uint32_t *first_nodes_, const Node *nodes_, const uint8_t *node_chars_
+		) : glyphs(glyphs_),
+			glyph_widths(glyph_widths_),
+			glyph_char_starts(glyph_char_starts_), chars(chars_),
+			glyph_coord_starts(glyph_coord_starts_), coords(coords_),
+			first_nodes(first_nodes_), nodes(nodes_), node_chars(node_chars_) {
+	}
 	const uint32_t glyphs = 0;
 	const float *glyph_widths = nullptr;
 
@@ -30,8 +37,19 @@ struct PathFont {
 	const uint32_t *glyph_coord_starts = nullptr; //indices into 'coords' table
 	const float *coords = nullptr;
 
-	//computed in constructor:
-	std::map< std::string, uint32_t > glyph_map;
+	//glyph characters as a trie, used by match():
+	// (generated along with the other tables by make-PathFont-font.py)
+	struct Node {
+		uint32_t glyph; //glyph spelled by the path to this node, or -1U
+		uint32_t children_begin, children_end; //range in nodes
+	};
+	const uint32_t *first_nodes = nullptr; //[256] node for each first character (or -1U)
+	const Node *nodes = nullptr; //(children of a node are next to each other, sorted by character)
+	const uint8_t *node_chars = nullptr; //last character of the path to each node
+
+	//longest glyph whose characters start [begin,end), or -1U if none does:
+	// (sets 'length' to the number of characters matched; no allocation, and one table lookup for single-character glyphs)
+	uint32_t match(char const *begin, char const *end, uint32_t *length) const;
 
 	//the default font:
 	static PathFont font;
@@ -3,35 +3,73 @@
 #include "LitColorTextureProgram.hpp"
 
 #include "DrawLines.hpp"
+#include "FrameArena.hpp"
 #include "Mesh.hpp"
 #include "Load.hpp"
 #include "gl_errors.hpp"
 #include "data_path.hpp"
+#include "HotReload.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include <random>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+//hot reloading (see HotReload.hpp): changes to picnic.pnct and picnic.scene are applied
+// to the loaded picnic scene and to the scene of every PlayMode:
+static Scene *picnic_scene_to_reload = nullptr; //(picnic_scene, once loaded)
+static std::vector< PlayMode * > play_modes;
 
 GLuint picnic_meshes_for_lit_color_texture_program = 0;
 Load< MeshBuffer > picnic_meshes(LoadTagDefault, []() -> MeshBuffer const * {
-	MeshBuffer const *ret = new MeshBuffer(data_path("picnic.pnct"));
+	//only meshes used by picnic.scene need to be uploaded:
+	MeshBuffer *ret = new MeshBuffer(data_path("picnic.pnct"), MeshBuffer::Residency::OnLookup);
 	picnic_meshes_for_lit_color_texture_program = ret->make_vao_for_program(lit_color_texture_program->program);
+
+	watch_file(data_path("picnic.pnct"), [ret]() {
+		std::vector< MeshChange > changes = ret->reload(data_path("picnic.pnct"));
+		if (picnic_scene_to_reload) patch_drawables(*picnic_scene_to_reload, *ret, changes);
+		for (PlayMode *mode : play_modes) {
+			mode->apply_mesh_changes(*ret, changes);
+		}
+	});
+
 	return ret;
-});
+}, "picnic.pnct");
 
 Load< Scene > picnic_scene(LoadTagDefault, []() -> Scene const * {
-	return new Scene(data_path("picnic.scene"), [&](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
-		Mesh const &mesh = picnic_meshes->lookup(mesh_name);
-
-		scene.drawables.emplace_back(transform);
-		Scene::Drawable &drawable = scene.drawables.back();
-		drawable.pipeline = lit_color_texture_program_pipeline;
-		drawable.pipeline.vao = picnic_meshes_for_lit_color_texture_program;
-		drawable.pipeline.type = mesh.type;
-		drawable.pipeline.start = mesh.start;
-		drawable.pipeline.count = mesh.count;
+	//drawables get picnic meshes drawn with the lit color texture program:
+	// (if picnic.scene was cooked and resolved against picnic.pnct by asset-tool, no mesh names are looked up)
+	Scene::MeshSource source;
+	source.file = "picnic.pnct";
+	source.buffer = picnic_meshes;
+	source.pipeline = lit_color_texture_program_pipeline;
+	source.pipeline.vao = picnic_meshes_for_lit_color_texture_program;
+	Scene *ret = new Scene(data_path("picnic.scene"), std::vector< Scene::MeshSource >{ source });
+
+	picnic_scene_to_reload = ret;
+	if (in_data_pack(data_path("picnic.scene"))) return ret; //(packed scenes don't change)
+
+	//(scene changes are found by comparing with the last version of the file)
+	auto last = std::make_shared< CookedScene::Contents >(CookedScene(data_path("picnic.scene")).contents());
+	watch_file(data_path("picnic.scene"), [ret,last]() {
+		CookedScene::Contents next = CookedScene(data_path("picnic.scene")).contents();
+		bool applied = apply_scene_changes(*ret, *last, next);
+		for (PlayMode *mode : play_modes) {
+			applied = apply_scene_changes(mode->scene, *last, next) && applied;
+		}
+		if (!applied) {
+			std::cerr << "WARNING: the hierarchy of picnic.scene changed; restart to see the changes." << std::endl;
+			return; //(keep comparing with the version that was loaded)
+		}
+		*last = std::move(next);
 	});
-});
+
+	return ret;
+}, "picnic.scene");
 
 PlayMode::PlayMode() : scene(*picnic_scene) {
     hotdogs.clear();
@@ -78,9 +116,31 @@ PlayMode::PlayMode() : scene(*picnic_scene) {
 	//get pointer to camera for convenience:
 	if (scene.cameras.size() != 1) throw std::runtime_error("Expecting scene to have exactly one camera, but it has " + std::to_string(scene.cameras.size()));
 	camera = &scene.cameras.front();
+
+	play_modes.emplace_back(this);
 }
 
 PlayMode::~PlayMode() {
+	play_modes.erase(std::find(play_modes.begin(), play_modes.end(), this));
+}
+
+void PlayMode::apply_mesh_changes(MeshBuffer const &buffer, std::vector< MeshChange > const &changes) {
+	patch_drawables(scene, buffer, changes);
+
+	//saved ranges used to duplicate objects:
+	auto patch = [&changes](GLenum *type, GLuint *start, GLuint *count) {
+		for (MeshChange const &change : changes) {
+			if (change.before.type == *type && change.before.start == *start && change.before.count == *count) {
+				*type = change.after.type;
+				*start = change.after.start;
+				*count = change.after.count;
+				return;
+			}
+		}
+	};
+	patch(&hotdog_vertex_type, &hotdog_vertex_start, &hotdog_vertex_count);
+	patch(&plate_vertex_type, &plate_vertex_start, &plate_vertex_count);
+	patch(&apple_vertex_type, &apple_vertex_start, &apple_vertex_count);
 }
 
 bool PlayMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
@@ -414,28 +474,33 @@ void PlayMode::draw(glm::uvec2 const &drawable_size) {
 
 	scene.draw(*camera);
 
-	{ //use DrawLines to overlay some text:
+	{ //use DrawLines::Text to overlay some text:
 		glDisable(GL_DEPTH_TEST);
 		float aspect = float(drawable_size.x) / float(drawable_size.y);
-		DrawLines lines(glm::mat4(
+		glm::mat4 world_to_clip(
 			1.0f / aspect, 0.0f, 0.0f, 0.0f,
 			0.0f, 1.0f, 0.0f, 0.0f,
 			0.0f, 0.0f, 1.0f, 0.0f,
 			0.0f, 0.0f, 0.0f, 1.0f
-		));
+		);
 
 		constexpr float H = 0.09f;
-        std::string lose = "";
+		//(built in the frame arena, so drawing the HUD doesn't allocate; see FrameArena.hpp)
+		FrameString hud = "                               Health: ";
+		char number[16];
+		std::snprintf(number, sizeof(number), "%d", health);
+		hud += number;
         if (health <= 0) {
-            lose = "       YOU LOSE!!!!";
+            hud += "       YOU LOSE!!!!";
         }
 
-		lines.draw_text("                               Health: " + std::to_string(health) + lose,
+		health_text.set(hud.data(), hud.data() + hud.size());
+		health_text.draw(world_to_clip,
 			glm::vec3(-aspect + 0.1f * H, -1.0 + 0.1f * H, 0.0),
 			glm::vec3(H, 0.0f, 0.0f), glm::vec3(0.0f, H, 0.0f),
 			glm::u8vec4(0x00, 0x00, 0x00, 0x00));
 		float ofs = 2.0f / drawable_size.y;
-		lines.draw_text("                               Health: " + std::to_string(health) + lose,
+		health_text.draw(world_to_clip,
 			glm::vec3(-aspect + 0.1f * H + ofs, -1.0 + + 0.1f * H + ofs, 0.0),
 			glm::vec3(H, 0.0f, 0.0f), glm::vec3(0.0f, H, 0.0f),
 			glm::u8vec4(0xff, 0xff, 0xff, 0x00));
@@ -1,12 +1,16 @@
 #include "Mode.hpp"
 
 #include "Scene.hpp"
+#include "DrawLines.hpp"
 
 #include <glm/glm.hpp>
 
 #include <vector>
 #include <deque>
 
+struct MeshBuffer; //(see Mesh.hpp)
+struct MeshChange; //(see Mesh.hpp)
+
 struct PlayMode : Mode {
 	PlayMode();
 	virtual ~PlayMode();
@@ -16,6 +20,9 @@ struct PlayMode : Mode {
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
 
+	//point this mode's drawables (and saved vertex ranges) at meshes changed by a hot reload:
+	void apply_mesh_changes(MeshBuffer const &buffer, std::vector< MeshChange > const &changes);
+
 	//----- game state -----
 
     // for duplicating hotdogs
@@ -37,6 +44,7 @@ struct PlayMode : Mode {
     Scene::Transform *apple_init_transform;
 
     int health = 20;
+	DrawLines::Text health_text; //(laid out again only when health changes)
 
     struct Cursor {
         // for aiming
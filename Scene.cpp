@@ -1,11 +1,74 @@
 #include "Scene.hpp"
 
 #include "gl_errors.hpp"
-#include "read_write_chunk.hpp"
+#include "ChunkFile.hpp"
+#include "Mesh.hpp"
+#include "CookedScene.hpp"
+#include "FrameArena.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include <fstream>
+#include <cmath>
+
+//-------------------------
+
+//collect the vertex ranges of meshlets that may be visible with the given object-to-clip matrix:
+// (clusters entirely outside a frustum plane are skipped; if 'cull_back' is set, so are clusters whose normal cone faces away from the eye)
+// adjacent survivors are merged into one range, so a fully visible mesh comes out as a single range
+static void cull_meshlets(glm::mat4 const &object_to_clip, bool cull_back, Meshlet const *meshlets, uint32_t meshlet_count, GLuint start,
+	FrameVector< GLint > *firsts_, FrameVector< GLsizei > *counts_) {
+	assert(firsts_ && counts_);
+	auto &firsts = *firsts_;
+	auto &counts = *counts_;
+
+	//frustum planes in object space (from rows of object_to_clip); inside is dot(plane.xyz, p) + plane.w >= 0:
+	glm::vec4 row[4];
+	for (uint32_t r = 0; r < 4; ++r) {
+		row[r] = glm::vec4(object_to_clip[0][r], object_to_clip[1][r], object_to_clip[2][r], object_to_clip[3][r]);
+	}
+	glm::vec4 planes[6] = {
+		row[3] + row[0], row[3] - row[0],
+		row[3] + row[1], row[3] - row[1],
+		row[3] + row[2], row[3] - row[2],
+	};
+	float plane_scale[6];
+	for (uint32_t p = 0; p < 6; ++p) {
+		plane_scale[p] = glm::length(glm::vec3(planes[p]));
+	}
+
+	//eye position in object space (the point that projects to w = 0):
+	// (orthographic projections have no eye point, so skip the cone test for them)
+	glm::vec4 eye_h = glm::inverse(object_to_clip) * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+	if (std::abs(eye_h.w) < 1e-20f) cull_back = false;
+	glm::vec3 eye = glm::vec3(eye_h) / eye_h.w;
+
+	for (uint32_t i = 0; i < meshlet_count; ++i) {
+		Meshlet const &meshlet = meshlets[i];
+
+		bool outside = false;
+		for (uint32_t p = 0; p < 6; ++p) {
+			if (glm::dot(glm::vec3(planes[p]), meshlet.center) + planes[p].w < -meshlet.radius * plane_scale[p]) {
+				outside = true;
+				break;
+			}
+		}
+		if (outside) continue;
+
+		if (cull_back) {
+			glm::vec3 to_center = meshlet.center - eye;
+			if (glm::dot(to_center, meshlet.cone_axis) >= meshlet.cone_cutoff * glm::length(to_center) + meshlet.radius) continue;
+		}
+
+		GLint first = GLint(start + meshlet.first);
+		if (!firsts.empty() && firsts.back() + counts.back() == first) {
+			counts.back() += GLsizei(meshlet.count);
+		} else {
+			firsts.emplace_back(first);
+			counts.emplace_back(GLsizei(meshlet.count));
+		}
+	}
+}
 
 //-------------------------
 
@@ -89,6 +152,12 @@ void Scene::draw(Camera const &camera) const {
 
 void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
 
+	//vertex ranges of drawables with meshlets (reused between drawables; from the frame arena, see FrameArena.hpp):
+	FrameVector< GLint > firsts;
+	FrameVector< GLsizei > counts;
+	//meshlet normal cones are only used when OpenGL is culling back faces (checked when first needed):
+	enum { Unknown, Off, On } back_face_culling = Unknown;
+
 	//Iterate through all drawables, sending each one to OpenGL:
 	for (auto const &drawable : drawables) {
 		//Reference to drawable's pipeline for convenience:
@@ -101,6 +170,25 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 		//skip any drawables that don't contain any vertices:
 		if (pipeline.count == 0) continue;
 
+		//the object-to-world matrix is used for culling and in all three of the uniforms below:
+		assert(drawable.transform); //drawables *must* have a transform
+		glm::mat4x3 object_to_world = drawable.transform->make_local_to_world();
+
+		//skip meshlets that can't be seen (and the whole drawable, if none can):
+		firsts.clear();
+		counts.clear();
+		if (pipeline.meshlet_count) {
+			if (back_face_culling == Unknown) {
+				GLint mode = 0, front = 0;
+				glGetIntegerv(GL_CULL_FACE_MODE, &mode);
+				glGetIntegerv(GL_FRONT_FACE, &front);
+				back_face_culling = (glIsEnabled(GL_CULL_FACE) && mode == GL_BACK && front == GL_CCW ? On : Off);
+			}
+			//(mirroring transforms flip the winding, so cones only apply to transforms that keep it)
+			bool cull_back = (back_face_culling == On && glm::determinant(glm::mat3(object_to_world)) > 0.0f);
+			cull_meshlets(world_to_clip * glm::mat4(object_to_world), cull_back, pipeline.meshlets, pipeline.meshlet_count, pipeline.start, &firsts, &counts);
+			if (firsts.empty()) continue;
+		}
 
 		//Set shader program:
 		glUseProgram(pipeline.program);
@@ -110,13 +198,17 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 
 		//Configure program uniforms:
 
-		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable.transform); //drawables *must* have a transform
-		glm::mat4x3 object_to_world = drawable.transform->make_local_to_world();
+		//positions of quantized meshes are decoded by folding the decode into the position matrices:
+		glm::mat4 vertex_to_object = glm::mat4(
+			glm::vec4(pipeline.position_scale.x, 0.0f, 0.0f, 0.0f),
+			glm::vec4(0.0f, pipeline.position_scale.y, 0.0f, 0.0f),
+			glm::vec4(0.0f, 0.0f, pipeline.position_scale.z, 0.0f),
+			glm::vec4(pipeline.position_offset, 1.0f)
+		);
 
 		//OBJECT_TO_CLIP takes vertices from object space to clip space:
 		if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
-			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
+			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world) * vertex_to_object;
 			glUniformMatrix4fv(pipeline.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
 		}
 
@@ -125,10 +217,12 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 
 		//OBJECT_TO_CLIP takes vertices from object space to light space:
 		if (pipeline.OBJECT_TO_LIGHT_mat4x3 != -1U) {
-			glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(object_to_light));
+			glm::mat4x3 vertex_to_light = object_to_light * vertex_to_object;
+			glUniformMatrix4x3fv(pipeline.OBJECT_TO_LIGHT_mat4x3, 1, GL_FALSE, glm::value_ptr(vertex_to_light));
 		}
 
 		//NORMAL_TO_CLIP takes normals from object space to light space:
+		// (normals are not quantized, so this does not include the position decode)
 		if (pipeline.NORMAL_TO_LIGHT_mat3 != -1U) {
 			glm::mat3 normal_to_light = glm::inverse(glm::transpose(glm::mat3(object_to_light)));
 			glUniformMatrix3fv(pipeline.NORMAL_TO_LIGHT_mat3, 1, GL_FALSE, glm::value_ptr(normal_to_light));
@@ -145,8 +239,14 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 			}
 		}
 
-		//draw the object:
-		glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
+		//draw the object (or the visible parts of it):
+		if (firsts.size() > 1) {
+			glMultiDrawArrays(pipeline.type, firsts.data(), counts.data(), GLsizei(firsts.size()));
+		} else if (firsts.size() == 1) {
+			glDrawArrays(pipeline.type, firsts[0], counts[0]);
+		} else {
+			glDrawArrays(pipeline.type, pipeline.start, pipeline.count);
+		}
 
 		//un-bind textures:
 		for (uint32_t i = 0; i < Drawable::Pipeline::TextureCount; ++i) {
@@ -169,147 +269,144 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 void Scene::load(std::string const &filename,
 	std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
 
-	std::ifstream file(filename, std::ios::binary);
+	load_file(filename, [&on_drawable,this](CookedScene const &cooked) {
+		return load(cooked, on_drawable);
+	});
+}
 
-	std::vector< char > names;
-	read_chunk(file, "str0", &names);
+void Scene::load(std::string const &filename, std::vector< MeshSource > const &sources) {
+	load_file(filename, [&sources,this](CookedScene const &cooked) {
+		return load(cooked, sources);
+	});
+}
 
-	struct HierarchyEntry {
-		uint32_t parent;
-		uint32_t name_begin;
-		uint32_t name_end;
-		glm::vec3 position;
-		glm::quat rotation;
-		glm::vec3 scale;
-	};
-	static_assert(sizeof(HierarchyEntry) == 4 + 4 + 4 + 4*3 + 4*4 + 4*3, "HierarchyEntry is packed.");
-	std::vector< HierarchyEntry > hierarchy;
-	read_chunk(file, "xfh0", &hierarchy);
-
-	struct MeshEntry {
-		uint32_t transform;
-		uint32_t name_begin;
-		uint32_t name_end;
-	};
-	static_assert(sizeof(MeshEntry) == 4 + 4 + 4, "MeshEntry is packed.");
-	std::vector< MeshEntry > meshes;
-	read_chunk(file, "msh0", &meshes);
-
-	struct CameraEntry {
-		uint32_t transform;
-		char type[4]; //"pers" or "orth"
-		float data; //fov in degrees for 'pers', scale for 'orth'
-		float clip_near, clip_far;
-	};
-	static_assert(sizeof(CameraEntry) == 4 + 4 + 4 + 4 + 4, "CameraEntry is packed.");
-	std::vector< CameraEntry > cameras;
-	read_chunk(file, "cam0", &cameras);
-
-	struct LightEntry {
-		uint32_t transform;
-		char type;
-		glm::u8vec3 color;
-		float energy;
-		float distance;
-		float fov;
-	};
-	static_assert(sizeof(LightEntry) == 4 + 1 + 3 + 4 + 4 + 4, "LightEntry is packed.");
-	std::vector< LightEntry > lights;
-	read_chunk(file, "lmp0", &lights);
+void Scene::load_file(std::string const &filename, std::function< std::vector< Transform * >(CookedScene const &) > const &load_cooked) {
+	ChunkFile file(filename);
 
+	//cooked scene files are used as stored; plain scene files are cooked as they are read:
+	CookedScene cooked(file);
+	std::vector< Transform * > hierarchy_transforms = load_cooked(cooked);
 
-	//--------------------------------
-	//Now that file is loaded, create transforms for hierarchy entries:
+	//load any extra that a subclass wants:
+	// (extra chunks are read sequentially from just after the last main chunk)
+	std::istream &extra = file.seek_after(*file.find(file.find("csn0") ? "csn0" : "lmp0"));
+	std::vector< char > names(cooked.names.begin(), cooked.names.end());
+	load_extra(extra, names, hierarchy_transforms);
 
-	std::vector< Transform * > hierarchy_transforms;
-	hierarchy_transforms.reserve(hierarchy.size());
+	if (extra.peek() != EOF) {
+		std::cerr << "WARNING: trailing data in scene file '" << filename << "'" << std::endl;
+	}
+}
 
-	for (auto const &h : hierarchy) {
-		transforms.emplace_back();
-		Transform *t = &transforms.back();
-		if (h.parent != -1U) {
-			if (h.parent >= hierarchy_transforms.size()) {
-				throw std::runtime_error("scene file '" + filename + "' did not contain transforms in topological-sort order.");
-			}
-			t->parent = hierarchy_transforms[h.parent];
-		}
+std::vector< Scene::Transform * > Scene::load(CookedScene const &cooked,
+	std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
 
-		if (h.name_begin <= h.name_end && h.name_end <= names.size()) {
-			t->name = std::string(names.begin() + h.name_begin, names.begin() + h.name_end);
-		} else {
-				throw std::runtime_error("scene file '" + filename + "' contains hierarchy entry with invalid name indices");
-		}
+	//(indices in 'cooked' were checked when it was loaded)
 
-		t->position = h.position;
-		t->rotation = h.rotation;
-		t->scale = h.scale;
+	std::vector< Transform * > hierarchy_transforms;
+	hierarchy_transforms.reserve(cooked.transforms.size);
 
+	for (auto const &c : cooked.transforms) {
+		transforms.emplace_back();
+		Transform *t = &transforms.back();
+		if (c.parent != -1U) t->parent = hierarchy_transforms[c.parent];
+		t->name.assign(cooked.names.data + c.name_begin, cooked.names.data + c.name_end);
+		t->position = c.position;
+		t->rotation = c.rotation;
+		t->scale = c.scale;
 		hierarchy_transforms.emplace_back(t);
 	}
-	assert(hierarchy_transforms.size() == hierarchy.size());
-
-	for (auto const &m : meshes) {
-		if (m.transform >= hierarchy_transforms.size()) {
-			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid transform index (" + std::to_string(m.transform) + ")");
-		}
-		if (!(m.name_begin <= m.name_end && m.name_end <= names.size())) {
-			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid name indices");
-		}
-		std::string name = std::string(names.begin() + m.name_begin, names.begin() + m.name_end);
 
-		if (on_drawable) {
-			on_drawable(*this, hierarchy_transforms[m.transform], name);
+	if (on_drawable) {
+		for (auto const &d : cooked.drawables) {
+			on_drawable(*this, hierarchy_transforms[d.transform], cooked.name(d.name_begin, d.name_end));
 		}
-
 	}
 
-	for (auto const &c : cameras) {
-		if (c.transform >= hierarchy_transforms.size()) {
-			throw std::runtime_error("scene file '" + filename + "' contains camera entry with invalid transform index (" + std::to_string(c.transform) + ")");
-		}
-		if (std::string(c.type, 4) != "pers") {
-			std::cout << "Ignoring non-perspective camera (" + std::string(c.type, 4) + ") stored in file." << std::endl;
-			continue;
-		}
+	for (auto const &c : cooked.cameras) {
 		this->cameras.emplace_back(hierarchy_transforms[c.transform]);
 		Camera *camera = &this->cameras.back();
-		camera->fovy = c.data / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
-		camera->near = c.clip_near;
-		//N.b. far plane is ignored because cameras use infinite perspective matrices.
+		camera->fovy = c.fovy;
+		camera->near = c.near;
 	}
 
-	for (auto const &l : lights) {
-		if (l.transform >= hierarchy_transforms.size()) {
-			throw std::runtime_error("scene file '" + filename + "' contains lamp entry with invalid transform index (" + std::to_string(l.transform) + ")");
-		}
-		if (l.type == 'p') {
-			//good
-		} else if (l.type == 'h') {
-			//fine
-		} else if (l.type == 's') {
-			//okay
-		} else if (l.type == 'd') {
-			//sure
-		} else {
-			std::cout << "Ignoring unrecognized lamp type (" + std::string(&l.type, 1) + ") stored in file." << std::endl;
-			continue;
-		}
+	for (auto const &l : cooked.lights) {
 		this->lights.emplace_back(hierarchy_transforms[l.transform]);
 		Light *light = &this->lights.back();
-		light->type = static_cast<Light::Type>(l.type);
-		light->energy = glm::vec3(l.color) / 255.0f * l.energy;
-		light->spot_fov = l.fov / 180.0f * 3.1415926f; //FOV is stored in degrees; convert to radians.
+		light->type = static_cast< Light::Type >(l.type);
+		light->energy = l.energy;
+		light->spot_fov = l.spot_fov;
 	}
 
-	//load any extra that a subclass wants:
-	load_extra(file, names, hierarchy_transforms);
+	return hierarchy_transforms;
+}
 
-	if (file.peek() != EOF) {
-		std::cerr << "WARNING: trailing data in scene file '" << filename << "'" << std::endl;
+std::vector< Scene::Transform * > Scene::load(CookedScene const &cooked, std::vector< MeshSource > const &sources) {
+	std::vector< Transform * > hierarchy_transforms = load(cooked, nullptr);
+	if (sources.empty()) return hierarchy_transforms;
+
+	auto add_drawable = [this](Transform *transform, MeshSource const &source, Mesh const &mesh) {
+		drawables.emplace_back(transform);
+		Drawable::Pipeline &pipeline = drawables.back().pipeline;
+		pipeline = source.pipeline;
+		pipeline.type = mesh.type;
+		pipeline.start = mesh.start;
+		pipeline.count = mesh.count;
+		pipeline.position_scale = mesh.position_scale;
+		pipeline.position_offset = mesh.position_offset;
+		pipeline.meshlets = mesh.meshlets;
+		pipeline.meshlet_count = mesh.meshlet_count;
+	};
+
+	//drawables that weren't resolved ahead of time look their mesh up by name in each source:
+	auto add_by_name = [&](CookedScene::Drawable const &d) {
+		std::string name = cooked.name(d.name_begin, d.name_end);
+		for (auto const &source : sources) {
+			uint32_t id = source.buffer->find_id(mesh_name_hash(name));
+			if (id != -1U && source.buffer->names[id] == name) {
+				add_drawable(hierarchy_transforms[d.transform], source, source.buffer->lookup(name));
+				return;
+			}
+		}
+		throw std::runtime_error("Looking up mesh '" + name + "' that doesn't exist in any mesh source.");
+	};
+
+	if (cooked.mesh_refs.size == 0) {
+		for (auto const &d : cooked.drawables) {
+			add_by_name(d);
+		}
+		return hierarchy_transforms;
 	}
 
+	//match the files the scene was resolved against with sources (once per file, not per drawable):
+	std::vector< MeshSource const * > buffer_sources(cooked.buffers.size, nullptr);
+	for (uint32_t b = 0; b < cooked.buffers.size; ++b) {
+		std::string name = cooked.buffer_name(cooked.buffers[b]);
+		for (auto const &source : sources) {
+			if (source.file.substr(source.file.rfind('/') + 1) != name) continue;
+			if (source.buffer->meshes.size() != cooked.buffers[b].mesh_count) {
+				throw std::runtime_error("Scene was resolved against a different version of mesh file '" + name + "'; it should be resolved again.");
+			}
+			buffer_sources[b] = &source;
+			break;
+		}
+	}
 
+	for (uint32_t i = 0; i < cooked.drawables.size; ++i) {
+		CookedScene::MeshRef const &ref = cooked.mesh_refs[i];
+		if (ref.buffer == -1U || !buffer_sources[ref.buffer]) {
+			add_by_name(cooked.drawables[i]);
+			continue;
+		}
+		MeshSource const &source = *buffer_sources[ref.buffer];
+		Mesh const &mesh = source.buffer->meshes[source.buffer->lookup_id(ref.name_hash)];
+		if (mesh.count != ref.count) {
+			throw std::runtime_error("Scene was resolved against a different version of mesh file '" + source.file + "'; it should be resolved again.");
+		}
+		add_drawable(hierarchy_transforms[cooked.drawables[i].transform], source, mesh);
+	}
 
+	return hierarchy_transforms;
 }
 
 //-------------------------
@@ -318,6 +415,10 @@ Scene::Scene(std::string const &filename, std::function< void(Scene &, Transform
 	load(filename, on_drawable);
 }
 
+Scene::Scene(std::string const &filename, std::vector< MeshSource > const &sources) {
+	load(filename, sources);
+}
+
 Scene::Scene(Scene const &other) {
 	set(other);
 }
@@ -22,6 +22,10 @@
 #include <vector>
 #include <unordered_map>
 
+struct Meshlet; //(see Mesh.hpp)
+struct CookedScene; //(see CookedScene.hpp)
+struct MeshBuffer; //(see Mesh.hpp)
+
 struct Scene {
 	struct Transform {
 		//Transform names are useful for debugging and looking up locations in a loaded scene:
@@ -65,6 +69,16 @@ struct Scene {
 			GLuint start = 0; //first vertex to draw; passed to glDrawArrays
 			GLuint count = 0; //number of vertices to draw; passed to glDrawArrays
 
+			//(optional) clusters covering [start, start+count), copied from Mesh::meshlets/meshlet_count:
+			// if present, clusters outside the view (or, with back-face culling on, facing away) are skipped
+			Meshlet const *meshlets = nullptr;
+			uint32_t meshlet_count = 0;
+
+			//vertex position decoding (for quantized meshes; copy from Mesh::position_scale/offset):
+			// applied as part of the object-to-clip and object-to-light matrices
+			glm::vec3 position_scale = glm::vec3(1.0f);
+			glm::vec3 position_offset = glm::vec3(0.0f);
+
 			//uniforms:
 			GLuint OBJECT_TO_CLIP_mat4 = -1U; //uniform location for object to clip space matrix
 			GLuint OBJECT_TO_LIGHT_mat4x3 = -1U; //uniform location for object to light space (== world space) matrix
@@ -128,13 +142,35 @@ struct Scene {
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
 	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f)) const;
 
-	//add transforms/objects/cameras from a scene file to this scene:
+	//add transforms/objects/cameras from a scene file (plain or cooked) to this scene:
 	// the 'on_drawable' callback gives your code a chance to look up mesh data and make Drawables:
 	// throws on file format errors
 	void load(std::string const &filename,
 		std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable = nullptr
 	);
 
+	//where drawables get their meshes, for loading without an 'on_drawable' callback:
+	struct MeshSource {
+		std::string file; //name of the mesh file (only the part after the last '/' is used)
+		MeshBuffer const *buffer = nullptr; //the loaded mesh file
+		Drawable::Pipeline pipeline; //copied to drawables with meshes in 'buffer' (with type, start, count, etc. set from the mesh)
+	};
+
+	//add transforms/objects/cameras from a scene file, making drawables from meshes in 'sources':
+	// if the file was resolved against these mesh files (by 'asset-tool resolve'), no mesh names are looked up
+	// throws on file format errors and meshes not found in any source (makes no drawables if 'sources' is empty)
+	void load(std::string const &filename, std::vector< MeshSource > const &sources);
+
+	//add transforms/objects/cameras from a cooked scene (see CookedScene.hpp), which the 'load' functions above use for all scene files:
+	// returns the new transforms, in the same order as cooked.transforms
+	std::vector< Transform * > load(CookedScene const &cooked,
+		std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable = nullptr
+	);
+	std::vector< Transform * > load(CookedScene const &cooked, std::vector< MeshSource > const &sources);
+
+	//(shared by the filename 'load' functions: opens and cooks the file, then reads extra chunks)
+	void load_file(std::string const &filename, std::function< std::vector< Transform * >(CookedScene const &) > const &load_cooked);
+
 	//this function is called to read extra chunks from the scene file after the main chunks are read:
 	// this is useful if you, e.g., subclassing scene to represent a game level/area
 	virtual void load_extra(std::istream &from, std::vector< char > const &str0, std::vector< Transform * > const &xfh0) { }
@@ -144,6 +180,7 @@ struct Scene {
 
 	//load a scene:
 	Scene(std::string const &filename, std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable);
+	Scene(std::string const &filename, std::vector< MeshSource > const &sources);
 
 	//copy a scene (with proper pointer fixup):
 	Scene(Scene const &); //...as a constructor
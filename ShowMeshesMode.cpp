@@ -2,6 +2,7 @@
 
 #include "ShowMeshesProgram.hpp"
 #include "DrawLines.hpp"
+#include "FrameArena.hpp"
 
 #include <iostream>
 
@@ -142,7 +143,10 @@ void ShowMeshesMode::draw(glm::uvec2 const &drawable_size) {
 		draw_lines.draw_box(mat, glm::u8vec4(0xdd, 0xdd, 0xdd, 0xff));
 
 		//mesh name:
-		draw_lines.draw_text("'" + current_mesh_name + "'",
+		FrameString label = "'";
+		label.append(current_mesh_name.begin(), current_mesh_name.end());
+		label += "'";
+		draw_lines.draw_text(label.data(), label.data() + label.size(),
 			current_mesh_min + glm::vec3(0.0f, -0.20f, 0.0f),
 			0.15f * glm::vec3(1.0f, 0.0f, 0.0f),
 			0.15f * glm::vec3(0.0f, 1.0f, 0.0f),
@@ -152,51 +156,45 @@ void ShowMeshesMode::draw(glm::uvec2 const &drawable_size) {
 }
 
 void ShowMeshesMode::select_prev_mesh() {
-	auto f = buffer.meshes.find(current_mesh_name);
-	if (f != buffer.meshes.end()) --f;
-	if (f == buffer.meshes.end()) f = buffer.meshes.begin();
-
-	if (f != buffer.meshes.end()) {
-		current_mesh_name = f->first;
-		scene_drawable->pipeline.type = f->second.type;
-		scene_drawable->pipeline.start = f->second.start;
-		scene_drawable->pipeline.count = f->second.count;
-		current_mesh_min = f->second.min;
-		current_mesh_max = f->second.max;
+	if (current_mesh != -1U && current_mesh > 0) {
+		select_mesh(current_mesh - 1);
 	} else {
-		current_mesh_name = "";
-		scene_drawable->pipeline.type = GL_TRIANGLES;
-		scene_drawable->pipeline.start = 0;
-		scene_drawable->pipeline.count = 0;
-		current_mesh_min = glm::vec3(0.0f);
-		current_mesh_max = glm::vec3(0.0f);
+		select_mesh(0);
 	}
 }
 
 void ShowMeshesMode::select_next_mesh() {
-	auto f = buffer.meshes.find(current_mesh_name);
-	if (f != buffer.meshes.end()) ++f;
-	if (f == buffer.meshes.end()) {
-		auto temp = buffer.meshes.rbegin();
-		if (temp != buffer.meshes.rend()) {
-			++temp;
-			f = temp.base();
-			assert(f != buffer.meshes.end());
-		}
+	if (current_mesh != -1U && current_mesh + 1 < buffer.meshes.size()) {
+		select_mesh(current_mesh + 1);
+	} else {
+		select_mesh(uint32_t(buffer.meshes.size()) - 1);
 	}
+}
 
-	if (f != buffer.meshes.end()) {
-		current_mesh_name = f->first;
-		scene_drawable->pipeline.type = f->second.type;
-		scene_drawable->pipeline.start = f->second.start;
-		scene_drawable->pipeline.count = f->second.count;
-		current_mesh_min = f->second.min;
-		current_mesh_max = f->second.max;
+void ShowMeshesMode::select_mesh(uint32_t id) {
+	if (id < buffer.meshes.size()) {
+		Mesh const &mesh = buffer.meshes[id];
+		current_mesh = id;
+		current_mesh_name = buffer.names[id];
+		scene_drawable->pipeline.type = mesh.type;
+		scene_drawable->pipeline.start = mesh.start;
+		scene_drawable->pipeline.count = mesh.count;
+		scene_drawable->pipeline.position_scale = mesh.position_scale;
+		scene_drawable->pipeline.position_offset = mesh.position_offset;
+		scene_drawable->pipeline.meshlets = mesh.meshlets;
+		scene_drawable->pipeline.meshlet_count = mesh.meshlet_count;
+		current_mesh_min = mesh.min;
+		current_mesh_max = mesh.max;
 	} else {
+		current_mesh = -1U;
 		current_mesh_name = "";
 		scene_drawable->pipeline.type = GL_TRIANGLES;
 		scene_drawable->pipeline.start = 0;
 		scene_drawable->pipeline.count = 0;
+		scene_drawable->pipeline.position_scale = glm::vec3(1.0f);
+		scene_drawable->pipeline.position_offset = glm::vec3(0.0f);
+		scene_drawable->pipeline.meshlets = nullptr;
+		scene_drawable->pipeline.meshlet_count = 0;
 		current_mesh_min = glm::vec3(0.0f);
 		current_mesh_max = glm::vec3(0.0f);
 	}
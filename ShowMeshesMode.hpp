@@ -30,12 +30,14 @@ struct ShowMeshesMode : Mode {
 	//MeshBuffer being viewed:
 	MeshBuffer const &buffer;
 
-	//currently selected mesh:
+	//currently selected mesh (by ID in buffer, in file order):
+	uint32_t current_mesh = -1U;
 	std::string current_mesh_name = "";
 	glm::vec3 current_mesh_min = glm::vec3(0.0f);
 	glm::vec3 current_mesh_max = glm::vec3(0.0f);
 	void select_prev_mesh();
 	void select_next_mesh();
+	void select_mesh(uint32_t id); //(clears selection if id is out of range)
 	
 	//Vertex array object used to bind mesh buffer for drawing:
 	GLuint vao = 0;
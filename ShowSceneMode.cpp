@@ -1,5 +1,6 @@
 #include "ShowSceneMode.hpp"
 #include "DrawLines.hpp"
+#include "FrameArena.hpp"
 
 #include <iostream>
 
@@ -121,7 +122,10 @@ void ShowSceneMode::draw(glm::uvec2 const &drawable_size) {
 			draw_lines.draw(xf(glm::vec3(0.0f)), xf(glm::vec3(0.0f, 0.0f, -len)), glm::u8vec4(0x00, 0x00, 0x88, 0xff));
 
 			//transform name:
-			draw_lines.draw_text("'" + transform.name + "'",
+			FrameString label = "'";
+			label.append(transform.name.begin(), transform.name.end());
+			label += "'";
+			draw_lines.draw_text(label.data(), label.data() + label.size(),
 				xf(glm::vec3(0.05f, 0.0f, 0.05f)),
 				0.15f * xfd(glm::vec3(1.0f, 0.0f, 0.0f)),
 				0.15f * xfd(glm::vec3(0.0f, 0.0f, 1.0f)),
@@ -0,0 +1,127 @@
+#include "SpriteAtlas.hpp"
+
+#include "load_save_png.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+SpriteAtlas::SpriteAtlas(std::vector< std::string > const &files, uint32_t page_size_) : page_size(page_size_) {
+	//load images:
+	std::vector< glm::uvec2 > sizes(files.size());
+	std::vector< std::vector< glm::u8vec4 > > images(files.size());
+	for (size_t i = 0; i < files.size(); ++i) {
+		load_png(files[i], &sizes[i], &images[i], LowerLeftOrigin);
+	}
+
+	std::vector< uint32_t > image_pages;
+	std::vector< glm::uvec2 > corners;
+	uint32_t page_count = 0;
+	try {
+		page_count = pack(sizes, page_size, &image_pages, &corners);
+	} catch (std::runtime_error &e) {
+		throw std::runtime_error("Failed to pack sprite atlas: " + std::string(e.what()));
+	}
+
+	//copy images (with their borders) to pages, and upload pages:
+	std::vector< glm::u8vec4 > page(page_size * page_size);
+	for (uint32_t p = 0; p < page_count; ++p) {
+		std::fill(page.begin(), page.end(), glm::u8vec4(0));
+		for (size_t i = 0; i < files.size(); ++i) {
+			if (image_pages[i] != p) continue;
+			glm::uvec2 size = sizes[i];
+			glm::uvec2 corner = corners[i];
+			//border pixels repeat the image's edge, so filtering at the edge doesn't bring in neighbors:
+			for (uint32_t y = 0; y < size.y + 2; ++y) {
+				uint32_t from_y = std::min(std::max(y, 1U), size.y) - 1;
+				for (uint32_t x = 0; x < size.x + 2; ++x) {
+					uint32_t from_x = std::min(std::max(x, 1U), size.x) - 1;
+					page[(corner.y - 1 + y) * page_size + (corner.x - 1 + x)] = images[i][from_y * size.x + from_x];
+				}
+			}
+
+			Sprite sprite;
+			sprite.page = p;
+			sprite.min_tc = glm::vec2(corner) / float(page_size);
+			sprite.max_tc = glm::vec2(corner + size) / float(page_size);
+			sprite.size = size;
+			sprites[files[i]] = sprite;
+		}
+
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_size, page_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, page.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		pages.emplace_back(tex);
+	}
+
+	GL_ERRORS();
+}
+
+SpriteAtlas::~SpriteAtlas() {
+	if (!pages.empty()) glDeleteTextures(GLsizei(pages.size()), pages.data());
+	pages.clear();
+}
+
+Sprite const &SpriteAtlas::lookup(std::string const &file) const {
+	auto f = sprites.find(file);
+	if (f == sprites.end()) {
+		throw std::runtime_error("Sprite atlas has no sprite for '" + file + "'.");
+	}
+	return f->second;
+}
+
+uint32_t SpriteAtlas::pack(std::vector< glm::uvec2 > const &sizes, uint32_t page_size, std::vector< uint32_t > *pages_, std::vector< glm::uvec2 > *corners_) {
+	assert(pages_);
+	auto &pages = *pages_;
+	assert(corners_);
+	auto &corners = *corners_;
+
+	pages.assign(sizes.size(), 0);
+	corners.assign(sizes.size(), glm::uvec2(0));
+
+	//place tallest first, so rows waste little height:
+	std::vector< uint32_t > order(sizes.size());
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return sizes[a].y > sizes[b].y;
+	});
+
+	uint32_t page = 0;
+	uint32_t row_y = 0; //bottom of current row
+	uint32_t row_height = 0; //(including borders)
+	uint32_t x = 0; //left of next image in current row
+	bool used = false; //anything on the current page?
+	for (uint32_t i : order) {
+		glm::uvec2 padded = sizes[i] + glm::uvec2(2);
+		if (padded.x > page_size || padded.y > page_size) {
+			throw std::runtime_error("image " + std::to_string(i) + " (" + std::to_string(sizes[i].x) + "x" + std::to_string(sizes[i].y) + ") is larger than a page (" + std::to_string(page_size) + "x" + std::to_string(page_size) + ", with a one-pixel border).");
+		}
+		if (x + padded.x > page_size) { //next row
+			row_y += row_height;
+			row_height = 0;
+			x = 0;
+		}
+		if (row_y + padded.y > page_size) { //next page
+			page += 1;
+			row_y = 0;
+			row_height = 0;
+			x = 0;
+		}
+		pages[i] = page;
+		corners[i] = glm::uvec2(x + 1, row_y + 1);
+		x += padded.x;
+		row_height = std::max(row_height, padded.y);
+		used = true;
+	}
+
+	return used ? page + 1 : 0;
+}
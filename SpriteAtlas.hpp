@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * A SpriteAtlas packs images into a few large textures ("pages") at load time,
+ *  so that DrawSprites can draw many different sprites with one draw per page.
+ *
+ * //at global scope:
+ * Load< SpriteAtlas > hud_atlas(LoadTagDefault, []() -> SpriteAtlas const * {
+ *     return new SpriteAtlas({ data_path("heart.png"), data_path("coin.png") });
+ * });
+ *
+ * //later:
+ * Sprite const &heart = hud_atlas->lookup(data_path("heart.png"));
+ *
+ */
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct Sprite {
+	uint32_t page = 0; //index in SpriteAtlas::pages
+	glm::vec2 min_tc = glm::vec2(0.0f); //texture coordinates of the image's lower left...
+	glm::vec2 max_tc = glm::vec2(0.0f); //...and upper right corners
+	glm::uvec2 size = glm::uvec2(0); //image size, in pixels
+};
+
+struct SpriteAtlas {
+	//load each PNG file (through load_png) and pack them into pages of page_size x page_size pixels:
+	// (throws if a file can't be loaded or doesn't fit on a page)
+	explicit SpriteAtlas(std::vector< std::string > const &files, uint32_t page_size = 1024);
+	~SpriteAtlas();
+
+	//(owns textures, so can't be copied)
+	SpriteAtlas(SpriteAtlas const &) = delete;
+	SpriteAtlas &operator=(SpriteAtlas const &) = delete;
+
+	//sprite for a file passed to the constructor (throws if there isn't one):
+	Sprite const &lookup(std::string const &file) const;
+
+	std::map< std::string, Sprite > sprites; //by file
+	std::vector< GLuint > pages; //GL_TEXTURE_2D textures, RGBA, page_size x page_size
+	uint32_t page_size = 0;
+
+	//where images of these sizes go on pages of page_size x page_size:
+	// images are placed in rows (tallest first), each with a one-pixel border (to keep filtering from reaching neighbors)
+	// returns the number of pages used, and sets (*pages)[i] and (*corners)[i] to where image i goes
+	static uint32_t pack(std::vector< glm::uvec2 > const &sizes, uint32_t page_size, std::vector< uint32_t > *pages, std::vector< glm::uvec2 > *corners);
+};
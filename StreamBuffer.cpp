@@ -0,0 +1,115 @@
+#include "StreamBuffer.hpp"
+
+#include "Load.hpp"
+#include "gl_errors.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+StreamBuffer::StreamBuffer(size_t size_) : size(size_) {
+	assert(size > 0);
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GL_ERRORS(); //PARANOIA: make sure nothing strange happened during setup
+}
+
+StreamBuffer::~StreamBuffer() {
+	for (Region &region : regions) {
+		if (region.fence) glDeleteSync(region.fence);
+	}
+	regions.clear();
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+size_t StreamBuffer::write(void const *data, size_t bytes, size_t alignment) {
+	assert(alignment > 0);
+
+	//fence the last write (the commands that use it have been issued by now):
+	if (!regions.empty() && regions.back().fence == nullptr) {
+		regions.back().fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	if (bytes * 3 > size) {
+		//grow, so a few writes this size fit before coming back around (and waiting on the GPU);
+		// re-specifying the buffer gives it fresh storage, so earlier draws don't need to be waited for:
+		while (size < bytes * 3) size *= 2;
+		for (Region &region : regions) {
+			glDeleteSync(region.fence);
+		}
+		regions.clear();
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		head = 0;
+	}
+
+	size_t offset = (head + alignment - 1) / alignment * alignment;
+	if (offset + bytes > size) offset = 0; //(wrap around)
+
+	wait_for(offset, offset + bytes);
+
+	if (bytes > 0) {
+		void *to = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		if (!to) {
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			throw std::runtime_error("Failed to map " + std::to_string(bytes) + " bytes of stream buffer.");
+		}
+		std::memcpy(to, data, bytes);
+		if (glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE) {
+			//(mapped contents can be lost, e.g. on a display mode change; rare enough to just write again the slow way)
+			glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+		}
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	regions.emplace_back(Region{offset, offset + bytes, nullptr});
+	head = offset + bytes;
+
+	return offset;
+}
+
+void StreamBuffer::wait_for(size_t begin, size_t end) {
+	//fences signal in order, so waiting on the newest overlapping region covers the older ones as well:
+	size_t newest = regions.size();
+	for (size_t i = regions.size(); i > 0; --i) {
+		if (regions[i-1].begin < end && begin < regions[i-1].end) {
+			newest = i-1;
+			break;
+		}
+	}
+	if (newest == regions.size()) return;
+
+	GLsync fence = regions[newest].fence;
+	assert(fence && "regions are fenced before anything waits on them");
+	while (true) {
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL); //(timeout is in nanoseconds)
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) break;
+		if (result == GL_WAIT_FAILED) throw std::runtime_error("Failed to wait for stream buffer fence.");
+		//GL_TIMEOUT_EXPIRED: keep waiting
+	}
+
+	for (size_t i = 0; i <= newest; ++i) {
+		glDeleteSync(regions[i].fence);
+	}
+	regions.erase(regions.begin(), regions.begin() + newest + 1);
+}
+
+
+static StreamBuffer *shared_vertex_stream = nullptr;
+
+static Load< void > make_vertex_stream(LoadTagEarly, [](){
+	//4MB is room for ~130k DrawLines lines before coming back around to the start:
+	shared_vertex_stream = new StreamBuffer(4 << 20);
+}, "vertex stream");
+
+StreamBuffer &vertex_stream() {
+	assert(shared_vertex_stream && "vertex_stream() is made by a load function");
+	return *shared_vertex_stream;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+ * A StreamBuffer is a vertex buffer used as a ring, for data that is written
+ *  once, drawn, and thrown away (e.g. DrawLines vertices).
+ *
+ * Each write() maps just the range it writes with GL_MAP_UNSYNCHRONIZED_BIT
+ *  and GL_MAP_INVALIDATE_RANGE_BIT, so the driver doesn't wait for (or copy
+ *  around) draws still reading other parts of the buffer. Instead, each written
+ *  region gets a fence (glFenceSync), and a write only waits for the fences of
+ *  regions it is about to overwrite -- which, with a big enough buffer, have
+ *  long since finished.
+ *
+ * (Written regions are fenced when the next write happens, since by then the
+ *  draws that use them have been issued.)
+ *
+ */
+
+#include "GL.hpp"
+
+#include <cstddef>
+#include <deque>
+
+struct StreamBuffer {
+	//make a buffer of 'size' bytes:
+	explicit StreamBuffer(size_t size);
+	~StreamBuffer();
+
+	//(owns a buffer, so can't be copied)
+	StreamBuffer(StreamBuffer const &) = delete;
+	StreamBuffer &operator=(StreamBuffer const &) = delete;
+
+	//copy 'bytes' bytes from 'data' into the buffer at a multiple of 'alignment':
+	// returns the offset written to (e.g. divide by the vertex size to get a 'first' for glDrawArrays)
+	// (writes bigger than a third of the buffer make it bigger; this re-specifies it, but keeps its name)
+	// (leaves GL_ARRAY_BUFFER bound to 0)
+	size_t write(void const *data, size_t bytes, size_t alignment);
+
+	GLuint buffer = 0; //bind this in vertex array objects
+	size_t size = 0;
+
+	//----- internals -----
+	size_t head = 0; //next write goes here or after
+
+	//regions written, oldest first, with fences for the commands that use them:
+	struct Region {
+		size_t begin, end;
+		GLsync fence; //(nullptr if the region was just written)
+	};
+	std::deque< Region > regions;
+
+	//wait for commands using [begin,end) to finish:
+	void wait_for(size_t begin, size_t end);
+};
+
+//stream buffer shared by the immediate-mode drawing helpers (DrawLines, DrawSprites):
+// (made at LoadTagEarly)
+StreamBuffer &vertex_stream();
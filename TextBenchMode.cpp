@@ -0,0 +1,76 @@
+#include "TextBenchMode.hpp"
+
+#include "DrawLines.hpp"
+#include "GL.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+TextBenchMode::TextBenchMode() {
+	//every printable ASCII character, with each line starting one character later than the last:
+	lines.reserve(Lines);
+	for (uint32_t l = 0; l < Lines; ++l) {
+		std::string line;
+		line.reserve(Columns);
+		for (uint32_t c = 0; c < Columns; ++c) {
+			line += char(' ' + (l + c) % ('~' - ' ' + 1));
+		}
+		lines.emplace_back(line);
+	}
+
+	report_time = std::chrono::steady_clock::now();
+}
+
+TextBenchMode::~TextBenchMode() {
+}
+
+bool TextBenchMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_ESCAPE) {
+		Mode::set_current(nullptr);
+		return true;
+	}
+	return false;
+}
+
+void TextBenchMode::draw(glm::uvec2 const &drawable_size) {
+	typedef std::chrono::steady_clock Clock;
+	auto ms = [](Clock::duration d) { return std::chrono::duration< double, std::milli >(d).count(); };
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_DEPTH_TEST);
+
+	Clock::time_point before_layout = Clock::now();
+	{ //lay out all of the lines, sized so they fill the window (so none are culled):
+		DrawLines draw_lines(glm::mat4(1.0f));
+		float line_height = 1.9f / Lines;
+		glm::vec3 x = glm::vec3(1.9f / (0.6f * Columns), 0.0f, 0.0f);
+		glm::vec3 y = glm::vec3(0.0f, line_height, 0.0f);
+		for (uint32_t l = 0; l < Lines; ++l) {
+			draw_lines.draw_text(lines[l], glm::vec3(-0.95f, 0.95f - (l + 1) * line_height, 0.0f), x, y, glm::u8vec4(0xff));
+		}
+	}
+	Clock::time_point before_flush = Clock::now();
+	//(flushed here, rather than by show-meshes' main loop, so it can be timed; waits for the GPU so the time includes drawing)
+	DrawLines::flush();
+	glFinish();
+	Clock::time_point after_flush = Clock::now();
+
+	frames += 1;
+	layout_ms += ms(before_flush - before_layout);
+	flush_ms += ms(after_flush - before_flush);
+
+	double report_ms = ms(after_flush - report_time);
+	if (report_ms >= 1000.0) {
+		std::cout << std::fixed << std::setprecision(3)
+			<< "text-bench: " << Lines * Columns << " characters per frame; "
+			<< "layout " << layout_ms / frames << " ms, "
+			<< "flush " << flush_ms / frames << " ms, "
+			<< "frame " << report_ms / frames << " ms "
+			<< "(average of " << frames << " frames)" << std::endl;
+		report_time = after_flush;
+		frames = 0;
+		layout_ms = 0.0;
+		flush_ms = 0.0;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/*
+ *
+ * TextBenchMode draws 100k characters of DrawLines text every frame and prints
+ * how long laying them out (DrawLines::draw_text) and drawing them
+ * (DrawLines::flush) took per frame; run with 'show-meshes --text-bench'.
+ *
+ */
+
+#include "Mode.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct TextBenchMode : Mode {
+	TextBenchMode();
+	virtual ~TextBenchMode();
+
+	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
+	virtual void draw(glm::uvec2 const &drawable_size) override;
+
+	//text drawn every frame (Lines lines of Columns characters each):
+	static constexpr uint32_t Lines = 1000;
+	static constexpr uint32_t Columns = 100;
+	std::vector< std::string > lines;
+
+	//totals since the last report (printed about once a second):
+	std::chrono::steady_clock::time_point report_time;
+	uint32_t frames = 0;
+	double layout_ms = 0.0;
+	double flush_ms = 0.0;
+};
@@ -0,0 +1,81 @@
+#include "WideLineProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+Load< WideLineProgram > wide_line_program(LoadTagEarly, new_T< WideLineProgram >, "WideLineProgram");
+
+WideLineProgram::WideLineProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform vec2 VIEWPORT_SIZE;\n"
+		"uniform float FEATHER;\n"
+		"in vec3 A;\n" //per-instance...
+		"in vec3 B;\n"
+		"in vec4 Color;\n"
+		"in float Width;\n"
+		"out vec4 color;\n"
+		"out float across;\n" //pixels from the center of the line
+		"flat out float half_width;\n"
+		"void main() {\n"
+		"	vec4 a = OBJECT_TO_CLIP * vec4(A, 1.0);\n"
+		"	vec4 b = OBJECT_TO_CLIP * vec4(B, 1.0);\n"
+		//clip to the near plane (z > -w), so the division below is safe:
+		"	float da = a.z + a.w;\n"
+		"	float db = b.z + b.w;\n"
+		"	if (da < 0.0 && db < 0.0) {\n"
+		"		gl_Position = vec4(0.0, 0.0, 0.0, 1.0);\n" //(all corners the same: nothing drawn)
+		"		color = Color; across = 0.0; half_width = 0.0;\n"
+		"		return;\n"
+		"	}\n"
+		"	if (da < 0.0) a = mix(a, b, da / (da - db));\n"
+		"	if (db < 0.0) b = mix(b, a, db / (db - da));\n"
+		//endpoints in pixels:
+		"	vec2 pa = a.xy / a.w * 0.5 * VIEWPORT_SIZE;\n"
+		"	vec2 pb = b.xy / b.w * 0.5 * VIEWPORT_SIZE;\n"
+		"	vec2 along = pb - pa;\n"
+		"	along = (dot(along, along) > 1e-8 ? normalize(along) : vec2(1.0, 0.0));\n"
+		"	vec2 perp = vec2(-along.y, along.x);\n"
+		//corners of the strip are (a,-), (a,+), (b,-), (b,+); ends are extended by half the width (square caps):
+		"	half_width = 0.5 * Width;\n"
+		"	float extent = half_width + FEATHER;\n"
+		"	bool at_b = (gl_VertexID >= 2);\n"
+		"	float side = ((gl_VertexID & 1) == 1 ? 1.0 : -1.0);\n"
+		"	vec4 end = (at_b ? b : a);\n"
+		"	vec2 offset = side * extent * perp + (at_b ? half_width : -half_width) * along;\n"
+		"	gl_Position = vec4(end.xy + offset / (0.5 * VIEWPORT_SIZE) * end.w, end.zw);\n"
+		"	color = Color;\n"
+		"	across = side * extent;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"uniform float FEATHER;\n"
+		"in vec4 color;\n"
+		"in float across;\n"
+		"flat in float half_width;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	float coverage = (FEATHER > 0.0 ? clamp((half_width + FEATHER - abs(across)) / FEATHER, 0.0, 1.0) : 1.0);\n"
+		"	fragColor = vec4(color.rgb, color.a * coverage);\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	A_vec3 = glGetAttribLocation(program, "A");
+	B_vec3 = glGetAttribLocation(program, "B");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+	Width_float = glGetAttribLocation(program, "Width");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	VIEWPORT_SIZE_vec2 = glGetUniformLocation(program, "VIEWPORT_SIZE");
+	FEATHER_float = glGetUniformLocation(program, "FEATHER");
+}
+
+WideLineProgram::~WideLineProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
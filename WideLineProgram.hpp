@@ -0,0 +1,27 @@
+#pragma once
+
+#include "GL.hpp"
+#include "Load.hpp"
+
+//Shader program that draws lines of any width (used by DrawLines::draw_wide):
+// each instance is a segment, expanded to a screen-space quad (a four-vertex triangle strip)
+// with edges optionally faded out for anti-aliasing
+struct WideLineProgram {
+	WideLineProgram();
+	~WideLineProgram();
+
+	GLuint program = 0;
+	//Attribute (per-instance variable) locations:
+	GLuint A_vec3 = -1U;
+	GLuint B_vec3 = -1U;
+	GLuint Color_vec4 = -1U;
+	GLuint Width_float = -1U; //in pixels
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint VIEWPORT_SIZE_vec2 = -1U; //in pixels
+	GLuint FEATHER_float = -1U; //pixels over which edges fade out (0 for hard edges)
+	//Textures:
+	// none
+};
+
+extern Load< WideLineProgram > wide_line_program;
@@ -0,0 +1,629 @@
+//asset-tool: offline helpers for chunk-based asset files (.pnct, .pncq, .scene, ...)
+// (does not need an OpenGL context; run without arguments for usage)
+
+#include "read_write_chunk.hpp"
+#include "ChunkFile.hpp"
+#include "CookedScene.hpp"
+#include "mesh_name_hash.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+//a whole chunk, held in memory:
+struct Chunk {
+	ChunkInfo info;
+	std::vector< char > data; //(decoded)
+};
+
+static std::vector< Chunk > read_chunks(std::string const &in_file) {
+	std::ifstream in(in_file, std::ios::binary);
+	if (!in) throw std::runtime_error("Failed to open '" + in_file + "' for reading.");
+
+	std::vector< Chunk > chunks;
+	while (in.peek() != EOF) {
+		chunks.emplace_back();
+		chunks.back().info = read_chunk_header(in);
+		chunks.back().data.resize(size_t(chunks.back().info.size));
+		read_chunk_data(in, chunks.back().info, chunks.back().data.data());
+	}
+	return chunks;
+}
+
+//write chunks (each stored with its own info.flags), returning the size of the file:
+// (if the first chunk is a 'toc0', it is regenerated to match the other chunks)
+static uint64_t write_chunks(std::string const &out_file, std::vector< Chunk > const &chunks) {
+	bool has_toc = !chunks.empty() && chunks[0].info.magic == "toc0";
+
+	//store chunks first, since (compressed) sizes are needed for the table of contents:
+	std::vector< std::string > stored;
+	std::vector< ChunkTocEntry > toc;
+	for (auto const &chunk : chunks) {
+		if (has_toc && &chunk == &chunks[0]) continue;
+		std::ostringstream data;
+		write_chunk(chunk.info.magic, chunk.data, &data, chunk.info.flags);
+		stored.emplace_back(data.str());
+
+		std::istringstream header(stored.back());
+		ChunkInfo info = read_chunk_header(header);
+		toc.emplace_back();
+		std::memcpy(toc.back().magic, info.magic.data(), 4);
+		toc.back().flags = info.flags;
+		toc.back().size = info.size;
+		toc.back().stored_size = info.stored_size;
+	}
+
+	std::ofstream out(out_file, std::ios::binary);
+	if (has_toc) {
+		uint64_t offset = 8 + toc.size() * sizeof(ChunkTocEntry);
+		for (size_t i = 0; i < toc.size(); ++i) {
+			toc[i].offset = offset;
+			offset += stored[i].size();
+		}
+		write_chunk("toc0", toc, &out);
+	}
+	for (auto const &data : stored) {
+		out.write(data.data(), data.size());
+	}
+	if (!out) throw std::runtime_error("Failed to write '" + out_file + "'.");
+	return uint64_t(out.tellp());
+}
+
+//copy every chunk of 'in_file' to 'out_file', storing it with 'flags':
+static void recode_chunks(std::string const &in_file, std::string const &out_file, uint32_t flags) {
+	std::vector< Chunk > chunks = read_chunks(in_file);
+	uint64_t stored_before = 0;
+	for (auto &chunk : chunks) {
+		stored_before += chunk.info.stored_size;
+		chunk.info.flags = flags;
+	}
+
+	uint64_t wrote = write_chunks(out_file, chunks);
+
+	std::cout << "Wrote " << chunks.size() << " chunks (" << stored_before << " bytes of data in '" << in_file << "') as " << wrote << " bytes to '" << out_file << "'." << std::endl;
+}
+
+//add a table of contents ('toc0') to the start of a chunk file:
+static void add_toc(std::string const &in_file, std::string const &out_file) {
+	std::vector< Chunk > chunks = read_chunks(in_file);
+	if (chunks.empty() || chunks[0].info.magic != "toc0") {
+		chunks.emplace(chunks.begin());
+		chunks[0].info.magic = "toc0";
+	}
+
+	uint64_t wrote = write_chunks(out_file, chunks);
+
+	std::cout << "Wrote " << (chunks.size() - 1) << " chunks with table of contents (" << wrote << " bytes) to '" << out_file << "'." << std::endl;
+}
+
+//list the chunks in a file (reads only the headers or table of contents):
+static void list_chunks(std::string const &in_file) {
+	ChunkFile file(in_file);
+	for (auto const &chunk : file.chunks) {
+		std::cout << "'" << chunk.magic << "' at " << chunk.offset << ": " << chunk.size << " bytes";
+		if (chunk.flags & ChunkFlagCompressed) std::cout << " (compressed to " << chunk.stored_size << ")";
+		std::cout << std::endl;
+	}
+}
+
+//geometry of a mesh file (.pnct or .pncq), for commands that need vertex positions:
+struct MeshGeometry {
+	Chunk *vertices = nullptr; //'pnct' or 'pncq' chunk
+	size_t stride = 0; //bytes per vertex
+	Chunk *idx0 = nullptr;
+	Chunk *qnt0 = nullptr; //(only in .pncq files)
+	std::vector< std::array< uint32_t, 4 > > index; //name_begin, name_end, vertex_begin, vertex_end per mesh
+
+	//vertex positions, decoded to floats (in [0,1]^3 for .pncq files; position() applies each mesh's range):
+	std::vector< std::array< float, 3 > > positions;
+	std::vector< std::array< float, 3 > > offset, scale; //per mesh
+
+	std::array< float, 3 > position(size_t mesh, uint32_t v) const {
+		std::array< float, 3 > p;
+		for (uint32_t c = 0; c < 3; ++c) p[c] = offset[mesh][c] + scale[mesh][c] * positions[v][c];
+		return p;
+	}
+};
+
+//find and decode the geometry chunks in 'chunks' (pointers stay valid until 'chunks' is changed):
+static MeshGeometry read_mesh_geometry(std::vector< Chunk > &chunks, std::string const &in_file) {
+	auto find = [&](std::string const &magic) -> Chunk * {
+		for (auto &chunk : chunks) {
+			if (chunk.info.magic == magic) return &chunk;
+		}
+		return nullptr;
+	};
+
+	MeshGeometry geometry;
+	geometry.idx0 = find("idx0");
+	if (!geometry.idx0 || geometry.idx0->data.size() % (4*4) != 0) throw std::runtime_error("'" + in_file + "' has no valid 'idx0' chunk.");
+	geometry.index.resize(geometry.idx0->data.size() / (4*4));
+	std::memcpy(geometry.index.data(), geometry.idx0->data.data(), geometry.idx0->data.size());
+	size_t meshes = geometry.index.size();
+
+	geometry.offset.assign(meshes, std::array< float, 3 >{{0.0f, 0.0f, 0.0f}});
+	geometry.scale.assign(meshes, std::array< float, 3 >{{1.0f, 1.0f, 1.0f}});
+	if ((geometry.vertices = find("pnct"))) {
+		geometry.stride = 3*4+3*4+4*1+2*4;
+		geometry.positions.resize(geometry.vertices->data.size() / geometry.stride);
+		for (size_t v = 0; v < geometry.positions.size(); ++v) {
+			std::memcpy(geometry.positions[v].data(), &geometry.vertices->data[v * geometry.stride], 3*4);
+		}
+	} else if ((geometry.vertices = find("pncq")) && (geometry.qnt0 = find("qnt0")) && geometry.qnt0->data.size() == meshes * 6*4) {
+		geometry.stride = 4*2+4+4*1+2*2;
+		geometry.positions.resize(geometry.vertices->data.size() / geometry.stride);
+		for (size_t v = 0; v < geometry.positions.size(); ++v) {
+			uint16_t q[3];
+			std::memcpy(q, &geometry.vertices->data[v * geometry.stride], 3*2);
+			for (uint32_t c = 0; c < 3; ++c) geometry.positions[v][c] = q[c] / 65535.0f;
+		}
+		for (size_t m = 0; m < meshes; ++m) {
+			std::memcpy(geometry.offset[m].data(), &geometry.qnt0->data[m * 6*4], 3*4);
+			std::memcpy(geometry.scale[m].data(), &geometry.qnt0->data[m * 6*4 + 3*4], 3*4);
+			for (uint32_t c = 0; c < 3; ++c) geometry.scale[m][c] -= geometry.offset[m][c];
+		}
+	} else {
+		throw std::runtime_error("'" + in_file + "' has no vertex data (or is missing its 'qnt0' chunk).");
+	}
+
+	for (auto const &entry : geometry.index) {
+		if (!(entry[2] <= entry[3] && entry[3] <= geometry.positions.size())) throw std::runtime_error("index entry has out-of-range vertex start/count");
+	}
+	return geometry;
+}
+
+//bounds of each mesh: min.xyz, max.xyz, center.xyz, radius (the layout of 'bnd0'):
+static std::vector< float > compute_mesh_bounds(MeshGeometry const &geometry) {
+	std::vector< float > bounds;
+	for (size_t m = 0; m < geometry.index.size(); ++m) {
+		auto const &entry = geometry.index[m];
+
+		float lo[3], hi[3], center[3];
+		float radius2 = 0.0f;
+		for (uint32_t c = 0; c < 3; ++c) {
+			lo[c] = std::numeric_limits< float >::infinity();
+			hi[c] =-std::numeric_limits< float >::infinity();
+		}
+		for (uint32_t v = entry[2]; v < entry[3]; ++v) {
+			std::array< float, 3 > p = geometry.position(m, v);
+			for (uint32_t c = 0; c < 3; ++c) {
+				lo[c] = std::min(lo[c], p[c]);
+				hi[c] = std::max(hi[c], p[c]);
+			}
+		}
+		for (uint32_t c = 0; c < 3; ++c) {
+			center[c] = (entry[2] < entry[3] ? 0.5f * (lo[c] + hi[c]) : 0.0f);
+		}
+		for (uint32_t v = entry[2]; v < entry[3]; ++v) {
+			std::array< float, 3 > p = geometry.position(m, v);
+			float d2 = 0.0f;
+			for (uint32_t c = 0; c < 3; ++c) d2 += (p[c] - center[c]) * (p[c] - center[c]);
+			radius2 = std::max(radius2, d2);
+		}
+		bounds.insert(bounds.end(), lo, lo + 3);
+		bounds.insert(bounds.end(), hi, hi + 3);
+		bounds.insert(bounds.end(), center, center + 3);
+		bounds.emplace_back(std::sqrt(radius2));
+	}
+	return bounds;
+}
+
+//add (or replace) the 'bnd0' chunk of a mesh file (.pnct or .pncq) so MeshBuffer doesn't need to compute bounds:
+static void add_mesh_bounds(std::string const &in_file, std::string const &out_file) {
+	std::vector< Chunk > chunks = read_chunks(in_file);
+	chunks.erase(std::remove_if(chunks.begin(), chunks.end(), [](Chunk const &c) { return c.info.magic == "bnd0"; }), chunks.end());
+
+	MeshGeometry geometry = read_mesh_geometry(chunks, in_file);
+	std::vector< float > bounds = compute_mesh_bounds(geometry);
+
+	//'bnd0' goes right after the index (and quantization) chunks, where MeshBuffer looks for it:
+	Chunk chunk;
+	chunk.info.magic = "bnd0";
+	chunk.info.flags = geometry.idx0->info.flags;
+	chunk.data.resize(bounds.size() * sizeof(float));
+	std::memcpy(chunk.data.data(), bounds.data(), chunk.data.size());
+	size_t at = size_t((geometry.qnt0 ? geometry.qnt0 : geometry.idx0) - chunks.data()) + 1;
+	chunks.insert(chunks.begin() + at, chunk);
+
+	uint64_t wrote = write_chunks(out_file, chunks);
+
+	std::cout << "Wrote bounds for " << geometry.index.size() << " meshes (" << wrote << " bytes) to '" << out_file << "'." << std::endl;
+}
+
+//split the meshes of a mesh file into clusters of (about) MeshletTriangles triangles, each with bounds for culling:
+// triangles of each mesh are reordered (in place) so clusters are consecutive and spatially compact;
+// the clusters are stored in an 'mlt0' chunk (see Meshlet in Mesh.hpp)
+static void add_meshlets(std::string const &in_file, std::string const &out_file) {
+	constexpr uint32_t MeshletTriangles = 128;
+
+	std::vector< Chunk > chunks = read_chunks(in_file);
+	chunks.erase(std::remove_if(chunks.begin(), chunks.end(), [](Chunk const &c) { return c.info.magic == "mlt0"; }), chunks.end());
+
+	MeshGeometry geometry = read_mesh_geometry(chunks, in_file);
+
+	struct MeshletEntry {
+		uint32_t entry; //index entry
+		uint32_t first, count; //vertices, relative to the start of the mesh
+		float center[3], radius;
+		float cone_axis[3], cone_cutoff;
+	};
+	static_assert(sizeof(MeshletEntry) == 4*3+4*4+4*4, "MeshletEntry is packed.");
+	std::vector< MeshletEntry > meshlets;
+
+	//(index entries can name the same vertices; those are only reordered once)
+	std::map< std::pair< uint32_t, uint32_t >, uint32_t > clustered; //vertex range -> index entry whose clusters cover it
+	uint32_t clustered_meshes = 0;
+
+	for (uint32_t m = 0; m < geometry.index.size(); ++m) {
+		uint32_t begin = geometry.index[m][2];
+		uint32_t end = geometry.index[m][3];
+		//meshes with a single cluster's worth of triangles gain nothing from culling by cluster:
+		if ((end - begin) % 3 != 0 || (end - begin) / 3 <= MeshletTriangles) continue;
+
+		auto f = clustered.find(std::make_pair(begin, end));
+		if (f != clustered.end()) {
+			for (size_t i = 0, n = meshlets.size(); i < n; ++i) {
+				if (meshlets[i].entry != f->second) continue;
+				meshlets.emplace_back(meshlets[i]);
+				meshlets.back().entry = m;
+			}
+			clustered_meshes += 1;
+			continue;
+		}
+		bool overlaps = false;
+		for (auto const &other : geometry.index) {
+			if (other[2] < end && begin < other[3] && !(other[2] == begin && other[3] == end)) overlaps = true;
+		}
+		if (overlaps) {
+			std::cerr << "WARNING: mesh " << m << " shares some (but not all) of its vertices with another mesh, so it can't be reordered into clusters." << std::endl;
+			continue;
+		}
+		clustered.emplace(std::make_pair(begin, end), m);
+		clustered_meshes += 1;
+
+		uint32_t triangles = (end - begin) / 3;
+		auto vertex = [&](uint32_t t, uint32_t i) { return geometry.position(m, begin + 3 * t + i); };
+
+		//order triangles along a Morton (z-order) curve through the mesh's bounding box:
+		float lo[3], hi[3];
+		for (uint32_t c = 0; c < 3; ++c) {
+			lo[c] = std::numeric_limits< float >::infinity();
+			hi[c] =-std::numeric_limits< float >::infinity();
+		}
+		for (uint32_t v = begin; v < end; ++v) {
+			std::array< float, 3 > p = geometry.position(m, v);
+			for (uint32_t c = 0; c < 3; ++c) {
+				lo[c] = std::min(lo[c], p[c]);
+				hi[c] = std::max(hi[c], p[c]);
+			}
+		}
+		std::vector< std::pair< uint32_t, uint32_t > > order; //(Morton code of centroid, triangle)
+		order.reserve(triangles);
+		for (uint32_t t = 0; t < triangles; ++t) {
+			uint32_t code = 0;
+			for (uint32_t c = 0; c < 3; ++c) {
+				float centroid = (vertex(t, 0)[c] + vertex(t, 1)[c] + vertex(t, 2)[c]) / 3.0f;
+				float amt = (hi[c] > lo[c] ? (centroid - lo[c]) / (hi[c] - lo[c]) : 0.0f);
+				uint32_t cell = uint32_t(std::max(0.0f, std::min(1023.0f, amt * 1024.0f)));
+				for (uint32_t bit = 0; bit < 10; ++bit) {
+					code |= ((cell >> bit) & 1) << (3 * bit + c);
+				}
+			}
+			order.emplace_back(code, t);
+		}
+		std::sort(order.begin(), order.end());
+
+		{ //reorder vertex data (and decoded positions) to match:
+			size_t triangle_bytes = 3 * geometry.stride;
+			std::vector< char > data(triangles * triangle_bytes);
+			std::vector< std::array< float, 3 > > positions(3 * triangles);
+			for (uint32_t t = 0; t < triangles; ++t) {
+				uint32_t from = order[t].second;
+				std::memcpy(&data[t * triangle_bytes], &geometry.vertices->data[(begin + 3 * from) * geometry.stride], triangle_bytes);
+				for (uint32_t i = 0; i < 3; ++i) positions[3 * t + i] = geometry.positions[begin + 3 * from + i];
+			}
+			std::memcpy(&geometry.vertices->data[begin * geometry.stride], data.data(), data.size());
+			std::copy(positions.begin(), positions.end(), geometry.positions.begin() + begin);
+		}
+
+		//cut into clusters and compute their bounds:
+		for (uint32_t first = 0; first < triangles; first += MeshletTriangles) {
+			uint32_t last = std::min(triangles, first + MeshletTriangles);
+
+			MeshletEntry meshlet;
+			meshlet.entry = m;
+			meshlet.first = 3 * first;
+			meshlet.count = 3 * (last - first);
+
+			//bounding sphere around the cluster's box:
+			float clo[3], chi[3];
+			for (uint32_t c = 0; c < 3; ++c) {
+				clo[c] = std::numeric_limits< float >::infinity();
+				chi[c] =-std::numeric_limits< float >::infinity();
+			}
+			for (uint32_t t = first; t < last; ++t) {
+				for (uint32_t i = 0; i < 3; ++i) {
+					std::array< float, 3 > p = vertex(t, i);
+					for (uint32_t c = 0; c < 3; ++c) {
+						clo[c] = std::min(clo[c], p[c]);
+						chi[c] = std::max(chi[c], p[c]);
+					}
+				}
+			}
+			for (uint32_t c = 0; c < 3; ++c) meshlet.center[c] = 0.5f * (clo[c] + chi[c]);
+			float radius2 = 0.0f;
+			for (uint32_t t = first; t < last; ++t) {
+				for (uint32_t i = 0; i < 3; ++i) {
+					std::array< float, 3 > p = vertex(t, i);
+					float d2 = 0.0f;
+					for (uint32_t c = 0; c < 3; ++c) d2 += (p[c] - meshlet.center[c]) * (p[c] - meshlet.center[c]);
+					radius2 = std::max(radius2, d2);
+				}
+			}
+			meshlet.radius = std::sqrt(radius2);
+
+			//normal cone around the average (counter-clockwise) face normal:
+			std::vector< std::array< float, 3 > > normals;
+			float axis[3] = {0.0f, 0.0f, 0.0f};
+			for (uint32_t t = first; t < last; ++t) {
+				std::array< float, 3 > a = vertex(t, 0), b = vertex(t, 1), c = vertex(t, 2);
+				float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+				float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+				std::array< float, 3 > n{{ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0]}};
+				float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length == 0.0f) continue; //(degenerate triangles can't be seen from any side)
+				for (uint32_t i = 0; i < 3; ++i) {
+					n[i] /= length;
+					axis[i] += n[i];
+				}
+				normals.emplace_back(n);
+			}
+			float axis_length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			float min_dot = -1.0f;
+			if (axis_length > 0.0f) {
+				min_dot = 1.0f;
+				for (uint32_t i = 0; i < 3; ++i) axis[i] /= axis_length;
+				for (auto const &n : normals) {
+					min_dot = std::min(min_dot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+				}
+			}
+			if (min_dot > 0.0f) {
+				//every normal is within acos(min_dot) of the axis, so the cluster faces away when viewed from outside of a cone with half-angle asin(cutoff):
+				for (uint32_t i = 0; i < 3; ++i) meshlet.cone_axis[i] = axis[i];
+				meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+			} else {
+				//normals span a hemisphere (or more); never culled by facing:
+				meshlet.cone_axis[0] = 0.0f; meshlet.cone_axis[1] = 0.0f; meshlet.cone_axis[2] = 1.0f;
+				meshlet.cone_cutoff = 1.0f;
+			}
+
+			meshlets.emplace_back(meshlet);
+		}
+	}
+
+	//MeshBuffer expects each mesh's clusters together, in index order:
+	std::stable_sort(meshlets.begin(), meshlets.end(), [](MeshletEntry const &a, MeshletEntry const &b) { return a.entry < b.entry; });
+
+	//'mlt0' goes after the index, quantization, and bounds chunks:
+	Chunk chunk;
+	chunk.info.magic = "mlt0";
+	chunk.info.flags = geometry.idx0->info.flags;
+	chunk.data.resize(meshlets.size() * sizeof(MeshletEntry));
+	std::memcpy(chunk.data.data(), meshlets.data(), chunk.data.size());
+	Chunk const *after = (geometry.qnt0 ? geometry.qnt0 : geometry.idx0);
+	for (auto const &c : chunks) {
+		if (c.info.magic == "bnd0") after = &c;
+	}
+	chunks.insert(chunks.begin() + (after - chunks.data()) + 1, chunk);
+
+	uint64_t wrote = write_chunks(out_file, chunks);
+
+	std::cout << "Wrote " << meshlets.size() << " meshlets for " << clustered_meshes << " of " << geometry.index.size() << " meshes (" << wrote << " bytes) to '" << out_file << "'." << std::endl;
+}
+
+//replace the main chunks of a scene file with a cooked scene ('csn0'; see CookedScene.hpp):
+// (extra chunks are kept, after the cooked scene; the cooked scene is stored uncompressed so it can be mapped)
+static void cook_scene(std::string const &in_file, std::string const &out_file) {
+	std::vector< Chunk > chunks = read_chunks(in_file);
+	ChunkFile file(in_file);
+	if (file.find("csn0")) throw std::runtime_error("'" + in_file + "' is already cooked.");
+	CookedScene cooked(file);
+
+	std::vector< Chunk > out;
+	if (!chunks.empty() && chunks[0].info.magic == "toc0") out.emplace_back(chunks[0]);
+	out.emplace_back();
+	out.back().info.magic = "csn0";
+	out.back().data.assign(cooked.block, cooked.block + cooked.block_size);
+	bool extra = false;
+	for (auto const &chunk : chunks) {
+		if (extra) out.emplace_back(chunk);
+		if (chunk.info.magic == "lmp0") extra = true;
+	}
+
+	uint64_t wrote = write_chunks(out_file, out);
+
+	std::cout << "Wrote cooked scene with " << cooked.transforms.size << " transforms, " << cooked.drawables.size << " drawables, " << cooked.cameras.size << " cameras, and " << cooked.lights.size << " lights (" << wrote << " bytes) to '" << out_file << "'." << std::endl;
+}
+
+//store the meshes that a cooked scene's drawables use, as found in mesh file <meshes> (see CookedScene::MeshRef):
+// (run once per mesh file; drawables already resolved against other files are left alone)
+static void resolve_scene(std::string const &in_file, std::string const &meshes_file, std::string const &out_file) {
+	std::vector< Chunk > chunks = read_chunks(in_file);
+	auto csn0 = std::find_if(chunks.begin(), chunks.end(), [](Chunk const &c) { return c.info.magic == "csn0"; });
+	if (csn0 == chunks.end()) throw std::runtime_error("'" + in_file + "' is not a cooked scene (use 'cook' first).");
+	CookedScene::Contents contents;
+	{
+		ChunkFile file(in_file);
+		CookedScene cooked(file);
+		contents = cooked.contents();
+	}
+
+	//read meshes:
+	std::vector< Chunk > mesh_chunks = read_chunks(meshes_file);
+	MeshGeometry geometry = read_mesh_geometry(mesh_chunks, meshes_file);
+	std::vector< float > bounds;
+	auto bnd0 = std::find_if(mesh_chunks.begin(), mesh_chunks.end(), [](Chunk const &c) { return c.info.magic == "bnd0"; });
+	if (bnd0 != mesh_chunks.end() && bnd0->data.size() == geometry.index.size() * 10 * sizeof(float)) {
+		bounds.resize(geometry.index.size() * 10);
+		std::memcpy(bounds.data(), bnd0->data.data(), bnd0->data.size());
+	} else {
+		bounds = compute_mesh_bounds(geometry);
+	}
+	auto str0 = std::find_if(mesh_chunks.begin(), mesh_chunks.end(), [](Chunk const &c) { return c.info.magic == "str0"; });
+	if (str0 == mesh_chunks.end()) throw std::runtime_error("'" + meshes_file + "' has no 'str0' chunk.");
+	std::map< std::string, uint32_t > mesh_index; //name -> index entry (the first one with the name, as in MeshBuffer)
+	for (uint32_t m = 0; m < geometry.index.size(); ++m) {
+		auto const &entry = geometry.index[m];
+		if (!(entry[0] <= entry[1] && entry[1] <= str0->data.size())) throw std::runtime_error("index entry has out-of-range name begin/end");
+		mesh_index.emplace(std::string(str0->data.begin() + entry[0], str0->data.begin() + entry[1]), m);
+	}
+
+	//find (or add) this mesh file in the scene's buffers:
+	std::string buffer_name = meshes_file.substr(meshes_file.rfind('/') + 1);
+	uint32_t buffer = 0;
+	while (buffer < contents.buffers.size()) {
+		CookedScene::Buffer const &b = contents.buffers[buffer];
+		if (std::string(contents.buffer_names.begin() + b.name_begin, contents.buffer_names.begin() + b.name_end) == buffer_name) break;
+		++buffer;
+	}
+	if (buffer == contents.buffers.size()) {
+		contents.buffers.emplace_back();
+		contents.buffers.back().name_begin = uint32_t(contents.buffer_names.size());
+		contents.buffer_names.insert(contents.buffer_names.end(), buffer_name.begin(), buffer_name.end());
+		contents.buffers.back().name_end = uint32_t(contents.buffer_names.size());
+		contents.buffers.back().reserved = 0;
+	}
+	contents.buffers[buffer].mesh_count = uint32_t(mesh_index.size());
+
+	//resolve drawables that aren't already resolved against another file:
+	if (contents.mesh_refs.empty()) {
+		CookedScene::MeshRef unresolved = CookedScene::MeshRef();
+		unresolved.buffer = -1U;
+		contents.mesh_refs.assign(contents.drawables.size(), unresolved);
+	}
+	uint32_t resolved = 0, unresolved = 0;
+	for (size_t i = 0; i < contents.drawables.size(); ++i) {
+		CookedScene::MeshRef &ref = contents.mesh_refs[i];
+		if (ref.buffer != -1U && ref.buffer != buffer) continue;
+		CookedScene::Drawable const &d = contents.drawables[i];
+		std::string name(contents.names.begin() + d.name_begin, contents.names.begin() + d.name_end);
+		auto f = mesh_index.find(name);
+		if (f == mesh_index.end()) {
+			ref.buffer = -1U;
+			unresolved += 1;
+			continue;
+		}
+		uint32_t m = f->second;
+		ref.buffer = buffer;
+		ref.name_hash = mesh_name_hash(name);
+		ref.start = geometry.index[m][2];
+		ref.count = geometry.index[m][3] - geometry.index[m][2];
+		float const *b = &bounds[m * 10];
+		ref.min = glm::vec3(b[0], b[1], b[2]);
+		ref.max = glm::vec3(b[3], b[4], b[5]);
+		ref.sphere_center = glm::vec3(b[6], b[7], b[8]);
+		ref.sphere_radius = b[9];
+		resolved += 1;
+	}
+
+	csn0->data = CookedScene::make_block(contents);
+	uint64_t wrote = write_chunks(out_file, chunks);
+
+	std::cout << "Resolved " << resolved << " drawables against '" << buffer_name << "' (" << unresolved << " meshes not found there); wrote " << wrote << " bytes to '" << out_file << "'." << std::endl;
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	struct Command {
+		std::string usage;
+		std::function< void(std::vector< std::string > const &) > run;
+		size_t args;
+	};
+	std::map< std::string, Command > commands;
+
+	commands["compress"] = Command{
+		"compress <in> <out> -- store every chunk of <in> compressed",
+		[](std::vector< std::string > const &args) { recode_chunks(args[0], args[1], ChunkFlagCompressed); },
+		2
+	};
+	commands["decompress"] = Command{
+		"decompress <in> <out> -- store every chunk of <in> uncompressed",
+		[](std::vector< std::string > const &args) { recode_chunks(args[0], args[1], 0); },
+		2
+	};
+	commands["bounds"] = Command{
+		"bounds <in> <out> -- add precomputed per-mesh bounds ('bnd0') to mesh file <in>",
+		[](std::vector< std::string > const &args) { add_mesh_bounds(args[0], args[1]); },
+		2
+	};
+
+	commands["meshlets"] = Command{
+		"meshlets <in> <out> -- reorder the triangles of mesh file <in> into clusters with culling bounds ('mlt0')",
+		[](std::vector< std::string > const &args) { add_meshlets(args[0], args[1]); },
+		2
+	};
+
+	commands["cook"] = Command{
+		"cook <in> <out> -- convert scene file <in> to a cooked scene (which loads without parsing)",
+		[](std::vector< std::string > const &args) { cook_scene(args[0], args[1]); },
+		2
+	};
+
+	commands["resolve"] = Command{
+		"resolve <in> <meshes> <out> -- store where cooked scene <in> finds its meshes in mesh file <meshes> (so loading skips name lookups)",
+		[](std::vector< std::string > const &args) { resolve_scene(args[0], args[1], args[2]); },
+		3
+	};
+
+	commands["toc"] = Command{
+		"toc <in> <out> -- add a table of contents to <in> (so chunks can be read without scanning the file)",
+		[](std::vector< std::string > const &args) { add_toc(args[0], args[1]); },
+		2
+	};
+	commands["list"] = Command{
+		"list <in> -- list the chunks in <in>",
+		[](std::vector< std::string > const &args) { list_chunks(args[0]); },
+		1
+	};
+
+	auto f = (argc >= 2 ? commands.find(argv[1]) : commands.end());
+	if (f == commands.end() || size_t(argc - 2) != f->second.args) {
+		std::cerr << "Usage:" << std::endl;
+		for (auto const &command : commands) {
+			std::cerr << "\t" << argv[0] << " " << command.second.usage << std::endl;
+		}
+		return 1;
+	}
+
+	try {
+		f->second.run(std::vector< std::string >(argv + 2, argv + argc));
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
@@ -1,8 +1,13 @@
 #include "data_path.hpp"
 
+#include "Pack.hpp"
+
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -62,6 +67,83 @@ std::string data_path(std::string const &suffix) {
 	return path + "/" + suffix;
 }
 
+Pack const *data_pack() {
+	static std::unique_ptr< Pack > pack = []() -> std::unique_ptr< Pack > {
+		std::string filename = data_path("data.pack");
+		if (!std::ifstream(filename, std::ios::binary)) return nullptr; //no pack; everything is loose
+		return std::unique_ptr< Pack >(new Pack(filename));
+	}();
+	return pack.get();
+}
+
+//entry for a path made by data_path() in the data pack (or nullptr if there isn't one):
+static Pack::Entry const *find_in_data_pack(std::string const &path) {
+	std::string prefix = data_path("");
+	if (path.compare(0, prefix.size(), prefix) != 0 || !data_pack()) return nullptr;
+	return data_pack()->find(path.substr(prefix.size()));
+}
+
+bool in_data_pack(std::string const &path) {
+	return find_in_data_pack(path) != nullptr;
+}
+
+namespace {
+//read-only stream buffer over a block of memory (e.g., a pack entry):
+struct MemoryBuffer : std::streambuf {
+	MemoryBuffer(char const *data, uint64_t size) {
+		char *begin = const_cast< char * >(data); //(never written through; streambuf just doesn't take const pointers)
+		setg(begin, begin, begin + size);
+	}
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+		if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+		off_type at = off;
+		if (dir == std::ios_base::cur) at += gptr() - eback();
+		else if (dir == std::ios_base::end) at += egptr() - eback();
+		if (at < 0 || at > egptr() - eback()) return pos_type(off_type(-1));
+		setg(eback(), eback() + at, egptr());
+		return pos_type(at);
+	}
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+		return seekoff(off_type(pos), std::ios_base::beg, which);
+	}
+	std::streamsize xsgetn(char *to, std::streamsize count) override {
+		std::streamsize amount = std::min< std::streamsize >(count, egptr() - gptr());
+		std::memcpy(to, gptr(), size_t(amount));
+		setg(eback(), gptr() + amount, egptr());
+		return amount;
+	}
+};
+}
+
+DataFile::DataFile(std::string const &path) : stream(nullptr) {
+	//paths in the data directory are looked up in the pack first:
+	if (Pack::Entry const *entry = find_in_data_pack(path)) {
+		Pack const &pack = *data_pack();
+		packed = true;
+		size = entry->size;
+		mapped = pack.data(*entry);
+		char const *contents = mapped;
+		if (!contents) {
+			storage.resize(size_t(size));
+			pack.read(*entry, storage.data());
+			contents = storage.data();
+		}
+		buffer.reset(new MemoryBuffer(contents, size));
+		stream.rdbuf(buffer.get());
+		return;
+	}
+
+	//otherwise, the loose file:
+	std::unique_ptr< std::filebuf > file(new std::filebuf);
+	if (!file->open(path, std::ios::in | std::ios::binary)) {
+		throw std::runtime_error("Failed to open '" + path + "' for reading.");
+	}
+	size = uint64_t(file->pubseekoff(0, std::ios::end, std::ios::in));
+	file->pubseekpos(0, std::ios::in);
+	buffer = std::move(file);
+	stream.rdbuf(buffer.get());
+}
+
 /* From Rktcr; to be used eventually!
 static std::string make_user_dir(std::string const &app_name) {
 	std::string ret = "";
@@ -1,7 +1,42 @@
 #pragma once
 
+#include <istream>
+#include <memory>
 #include <string>
+#include <vector>
 
 //construct a path based on the location of the currently-running executable:
 // (e.g. if running /home/ix/game0/game.exe will return '/home/ix/game0/' + suffix)
 std::string data_path(std::string const &suffix);
+
+struct Pack;
+
+//the data pack ('data.pack' next to the executable, written by pack-tool), or nullptr if there isn't one:
+// (opened on first use; throws if it is malformed)
+Pack const *data_pack();
+
+//is the file at 'path' (made by data_path()) in the data pack?
+bool in_data_pack(std::string const &path);
+
+//A DataFile opens a file by path, looking for paths made by data_path() in the data pack first:
+// (so files can be packed for release and left loose during development)
+struct DataFile {
+	//throws if the file is in neither the pack nor on disk:
+	explicit DataFile(std::string const &path);
+
+	//(stream refers to the buffer, so can't be copied)
+	DataFile(DataFile const &) = delete;
+	DataFile &operator=(DataFile const &) = delete;
+
+	std::istream stream; //the file's contents
+	bool packed = false; //was the file found in the data pack?
+
+	//if the file is stored uncompressed in the data pack, its contents, in place in the pack's mapping:
+	// (valid for as long as the program runs; otherwise nullptr)
+	char const *mapped = nullptr;
+	uint64_t size = 0;
+
+	//-- internals ---
+	std::unique_ptr< std::streambuf > buffer; //(a std::filebuf, or a view of memory)
+	std::vector< char > storage; //decoded contents of a compressed pack entry
+};
@@ -0,0 +1,151 @@
+#include "lz4_block.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+	//format constants, from the block format description:
+	constexpr size_t MinMatch = 4; //shortest match that can be encoded
+	constexpr size_t LastLiterals = 5; //last bytes of a block are always literals
+	constexpr size_t MatchSearchLimit = 12; //last match must start at least this far from the end
+	constexpr size_t MaxOffset = 65535;
+
+	constexpr uint32_t HashLog = 16;
+
+	inline uint32_t read32(uint8_t const *at) {
+		uint32_t ret;
+		std::memcpy(&ret, at, 4);
+		return ret;
+	}
+
+	inline uint32_t hash32(uint32_t seq) {
+		return (seq * 2654435761U) >> (32 - HashLog);
+	}
+
+	//write a length that didn't fit in a token nybble:
+	inline void write_length(size_t length, std::vector< char > &dst) {
+		while (length >= 255) {
+			dst.push_back(char(255));
+			length -= 255;
+		}
+		dst.push_back(char(length));
+	}
+}
+
+size_t lz4_block_compress(void const *src_, size_t size, std::vector< char > *dst_) {
+	uint8_t const *src = reinterpret_cast< uint8_t const * >(src_);
+	auto &dst = *dst_;
+	size_t const start = dst.size();
+	dst.reserve(start + lz4_block_bound(size));
+
+	//emits [literals from anchor to 'at'] and (if match_length != 0) a match:
+	size_t anchor = 0;
+	auto emit = [&](size_t at, size_t offset, size_t match_length) {
+		size_t literals = at - anchor;
+		uint8_t token = uint8_t((literals < 15 ? literals : 15) << 4);
+		if (match_length) {
+			size_t m = match_length - MinMatch;
+			token |= uint8_t(m < 15 ? m : 15);
+		}
+		dst.push_back(char(token));
+		if (literals >= 15) write_length(literals - 15, dst);
+		dst.insert(dst.end(), src + anchor, src + at);
+		if (match_length) {
+			dst.push_back(char(offset & 0xff));
+			dst.push_back(char((offset >> 8) & 0xff));
+			if (match_length - MinMatch >= 15) write_length(match_length - MinMatch - 15, dst);
+		}
+	};
+
+	if (size >= MatchSearchLimit + 1) {
+		//table of most recent position for each hashed 4-byte sequence:
+		std::vector< uint32_t > table(size_t(1) << HashLog, -1U);
+
+		size_t const match_limit = size - LastLiterals; //matches must end at or before here
+		size_t at = 0;
+		while (at + MatchSearchLimit <= size) {
+			uint32_t seq = read32(src + at);
+			uint32_t &slot = table[hash32(seq)];
+			uint32_t candidate = slot;
+			slot = uint32_t(at);
+			if (candidate != -1U && at - candidate <= MaxOffset && read32(src + candidate) == seq) {
+				size_t length = MinMatch;
+				while (at + length < match_limit && src[candidate + length] == src[at + length]) ++length;
+				emit(at, at - candidate, length);
+				at += length;
+				anchor = at;
+			} else {
+				at += 1;
+			}
+		}
+	}
+
+	//final sequence is just literals:
+	emit(size, 0, 0);
+
+	return dst.size() - start;
+}
+
+void lz4_block_decompress(void const *src_, size_t src_size, void *dst_, size_t dst_size) {
+	uint8_t const *ip = reinterpret_cast< uint8_t const * >(src_);
+	uint8_t const *const iend = ip + src_size;
+	uint8_t *const dst = reinterpret_cast< uint8_t * >(dst_);
+	uint8_t *op = dst;
+	uint8_t *const oend = dst + dst_size;
+
+	auto read_length = [&](size_t length) {
+		uint8_t b;
+		do {
+			if (ip >= iend) throw std::runtime_error("Truncated length in compressed block.");
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return length;
+	};
+
+	while (true) {
+		if (ip >= iend) throw std::runtime_error("Truncated compressed block.");
+		uint8_t token = *ip++;
+
+		//literals:
+		size_t literals = token >> 4;
+		if (literals == 15) literals = read_length(literals);
+		if (literals > size_t(iend - ip) || literals > size_t(oend - op)) {
+			throw std::runtime_error("Literal run overflows compressed block.");
+		}
+		std::memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+
+		//the last sequence has no match:
+		if (ip == iend) break;
+
+		//match:
+		if (iend - ip < 2) throw std::runtime_error("Truncated match offset in compressed block.");
+		size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > size_t(op - dst)) {
+			throw std::runtime_error("Match offset out of range in compressed block.");
+		}
+		size_t length = token & 0xf;
+		if (length == 15) length = read_length(length);
+		length += MinMatch;
+		if (length > size_t(oend - op)) {
+			throw std::runtime_error("Match overflows decompressed block.");
+		}
+		uint8_t const *match = op - offset;
+		if (offset >= length) {
+			std::memcpy(op, match, length);
+			op += length;
+		} else {
+			//overlapping copy (repeating pattern) must go byte-by-byte:
+			for (size_t i = 0; i < length; ++i) {
+				*op++ = *match++;
+			}
+		}
+	}
+
+	if (op != oend) {
+		throw std::runtime_error("Compressed block decoded to an unexpected size.");
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/*
+ * Minimal in-tree codec for the LZ4 *block* format
+ *  (see: https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+ *
+ * Used by read_write_chunk.hpp to store compressed chunks.
+ * Decompression is bounds-checked; compression is a simple greedy matcher
+ *  (one hash table entry per 4-byte sequence) meant for offline asset tools.
+ *
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//worst-case compressed size for 'size' bytes of input:
+inline size_t lz4_block_bound(size_t size) { return size + size / 255 + 16; }
+
+//compress 'size' bytes from 'src', appending the compressed block to 'dst':
+// returns the number of bytes appended
+size_t lz4_block_compress(void const *src, size_t size, std::vector< char > *dst);
+
+//decompress a block of 'src_size' bytes into exactly 'dst_size' bytes at 'dst':
+// throws on malformed data (or if the decoded size is not exactly 'dst_size')
+void lz4_block_decompress(void const *src, size_t src_size, void *dst, size_t dst_size);
@@ -7,6 +7,16 @@
 //For asset loading:
 #include "Load.hpp"
 
+//for hot reloading assets:
+#include "HotReload.hpp"
+
+//for drawing lines, text, and sprites batched over the frame:
+#include "DrawLines.hpp"
+#include "DrawSprites.hpp"
+
+//for per-frame transient memory:
+#include "FrameArena.hpp"
+
 //GL.hpp will include a non-namespace-polluting set of opengl prototypes:
 #include "GL.hpp"
 
@@ -22,6 +32,7 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <cstdlib>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -92,6 +103,12 @@ int main(int argc, char **argv) {
 	//------------ load assets --------------
 	call_load_functions();
 
+	//report what loading cost (and, if LOAD_TRACE names a file, write a trace to view in chrome://tracing):
+	print_load_report(std::cout);
+	if (char const *trace = std::getenv("LOAD_TRACE")) {
+		write_load_trace(trace);
+	}
+
 	//------------ create game mode + make current --------------
 	Mode::set_current(std::make_shared< PlayMode >());
 
@@ -117,6 +134,9 @@ int main(int argc, char **argv) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
+		//free last frame's transient data (see FrameArena.hpp):
+		frame_arena().reset();
+
 		{ //(1) process any events that are pending
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
@@ -149,6 +169,9 @@ int main(int argc, char **argv) {
 			if (!Mode::current) break;
 		}
 
+		//hot reload any asset files that changed (see HotReload.hpp):
+		poll_file_watches();
+
 		{ //(2) call the current mode's "update" function to deal with elapsed time:
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
@@ -166,6 +189,10 @@ int main(int argc, char **argv) {
 		{ //(3) call the current mode's "draw" function to produce output:
 		
 			Mode::current->draw(drawable_size);
+
+			//draw the lines, text, and sprites the mode drew with DrawLines and DrawSprites:
+			DrawLines::flush();
+			DrawSprites::flush();
 		}
 
 		//Wait until the recently-drawn frame is shown before doing it all again:
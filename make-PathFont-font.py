@@ -506,6 +506,42 @@ for char_glyph in sorted(glyphs.items()):
 	for pair in glyph_lines:
 		out_coords += list(pair)
 
+#glyph characters as a trie for PathFont::match, laid out breadth-first so each node's children are next to each other:
+class TrieNode:
+	def __init__(self):
+		self.glyph = -1
+		self.children = dict()
+
+trie = TrieNode()
+for g in range(0, out_glyphs):
+	node = trie
+	for c in out_chars[out_glyph_char_starts[g]:(out_glyph_char_starts[g+1] if g + 1 < out_glyphs else len(out_chars))]:
+		if c not in node.children: node.children[c] = TrieNode()
+		node = node.children[c]
+	node.glyph = g
+
+out_first_nodes = [-1] * 256
+out_nodes = []
+out_node_chars = []
+order = []
+for c, child in sorted(trie.children.items()):
+	out_first_nodes[c] = len(order)
+	order.append(child)
+	out_node_chars.append(c)
+n = 0
+while n < len(order):
+	node = order[n]
+	begin = len(order)
+	for c, child in sorted(node.children.items()):
+		order.append(child)
+		out_node_chars.append(c)
+	out_nodes.append((node.glyph, begin, len(order)))
+	n += 1
+
+def index_str(i):
+	if i == -1: return '-1U'
+	else: return str(i)
+
 print("Font covers: " + ", ".join(map(lambda x: "'" + x + "'", sorted(glyphs.keys()))))
 missing = []
 for m in range(0x20, 0x7f):
@@ -553,8 +589,20 @@ w('\tconstexpr const float font_coords[' + str(len(out_coords)) + '] = {\n')
 wd(out_coords, "{:.6f}f", 6)
 w('\t};\n')
 
+w('\tconstexpr const uint32_t font_first_nodes[256] = {\n')
+wd(list(map(index_str, out_first_nodes)), "{}", 12)
+w('\t};\n')
+
+w('\tconstexpr const PathFont::Node font_nodes[' + str(len(out_nodes)) + '] = {\n')
+wd(list(map(lambda n: '{ ' + index_str(n[0]) + ', ' + str(n[1]) + ', ' + str(n[2]) + ' }', out_nodes)), "{}", 6)
+w('\t};\n')
+
+w('\tconstexpr const uint8_t font_node_chars[' + str(len(out_node_chars)) + '] = {\n')
+wd(out_node_chars, "{}", 12)
+w('\t};\n')
+
 
 w('}\n')
-w('PathFont PathFont::font(font_glyphs, font_glyph_widths, font_glyph_char_starts, font_chars, font_glyph_coord_starts, font_coords);\n')
+w('PathFont PathFont::font(font_glyphs, font_glyph_widths, font_glyph_char_starts, font_chars, font_glyph_coord_starts, font_coords, font_first_nodes, font_nodes, font_node_chars);\n')
 
 cppfile.close()
@@ -0,0 +1,25 @@
+#pragma once
+
+//64-bit FNV-1a hash of a mesh name, as used by MeshBuffer's lookup table (see Mesh.hpp):
+// (in its own header so tools that don't use OpenGL, like asset-tool, can hash names the same way)
+// (constexpr, so names known at compile time can be hashed at compile time, e.g.:
+//   constexpr uint64_t DishHash = mesh_name_hash("Dish"); ... meshes->lookup_id(DishHash) )
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+constexpr uint64_t mesh_name_hash(char const *name, size_t length) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; ++i) {
+		hash = (hash ^ uint8_t(name[i])) * 1099511628211ULL;
+	}
+	return hash;
+}
+template< size_t N >
+constexpr uint64_t mesh_name_hash(char const (&name)[N]) {
+	return mesh_name_hash(name, N - 1);
+}
+inline uint64_t mesh_name_hash(std::string const &name) {
+	return mesh_name_hash(name.data(), name.size());
+}
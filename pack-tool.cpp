@@ -0,0 +1,94 @@
+//pack-tool: store data files in a pack (see Pack.hpp), which the game reads in place of loose files
+// (run without arguments for usage)
+
+#include "Pack.hpp"
+#include "read_write_chunk.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	std::vector< std::string > args(argv + 1, argv + argc);
+	bool compress = false;
+	if (!args.empty() && args[0] == "--compress") {
+		compress = true;
+		args.erase(args.begin());
+	}
+	if (args.size() < 2) {
+		std::cerr << "Usage:\n"
+			"\t" << argv[0] << " [--compress] <out.pack> <base-dir> [<file> ...]\n"
+			"Stores each <file> in <out.pack> under its path relative to <base-dir>\n"
+			" (the name the game passes to data_path()); with --compress, files are\n"
+			" stored compressed when that makes them smaller.\n"
+			"E.g.: " << argv[0] << " dist/data.pack dist dist/picnic.pnct dist/picnic.scene\n"
+			" or, from inside dist: " << argv[0] << " data.pack . picnic.pnct picnic.scene" << std::endl;
+		return 1;
+	}
+
+	try {
+		std::string out_file = args[0];
+		//leading './' means nothing, so is dropped from the base and from files (and a base of '.' is no prefix at all):
+		auto strip_dot = [](std::string path) {
+			while (path.size() >= 2 && path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+				path.erase(0, 2);
+			}
+			return path;
+		};
+		std::string base = strip_dot(args[1]);
+		if (base == ".") base = "";
+		if (!base.empty() && base.back() != '/' && base.back() != '\\') base += '/';
+
+		std::vector< std::pair< std::string, std::string > > files;
+		for (size_t i = 2; i < args.size(); ++i) {
+			std::string const &path = args[i];
+			std::string relative = strip_dot(path);
+			if (relative.compare(0, base.size(), base) != 0 || relative.size() == base.size()) {
+				throw std::runtime_error("File '" + path + "' is not inside base directory '" + args[1] + "'.");
+			}
+			std::string name = relative.substr(base.size());
+			for (char &c : name) {
+				if (c == '\\') c = '/';
+			}
+			files.emplace_back(name, path);
+		}
+
+		Pack::write(out_file, files, compress);
+
+		//report what went in:
+		Pack pack(out_file);
+		uint64_t total_size = 0;
+		uint64_t total_stored = 0;
+		for (uint32_t i = 0; i < pack.header->entry_count; ++i) {
+			Pack::Entry const &entry = pack.entries[i];
+			std::cout << "  " << pack.name(entry) << ": " << entry.size << " bytes";
+			if (entry.flags & ChunkFlagCompressed) std::cout << " (" << entry.stored_size << " stored)";
+			std::cout << "\n";
+			total_size += entry.size;
+			total_stored += entry.stored_size;
+		}
+		std::cout << "Wrote " << pack.header->entry_count << " files (" << total_size << " bytes; "
+			<< total_stored << " stored) to '" << out_file << "' (" << pack.mapping_size << " bytes)." << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		throw;
+	}
+#endif
+}
@@ -1,49 +1,334 @@
 #pragma once
 
+#include "lz4_block.hpp"
+
 #include <iostream>
 #include <vector>
+#include <string>
 #include <stdexcept>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <exception>
 
 //helper function that reads an array of structures preceded by a simple header:
 //Expected format:
 // |ma|gi|c.|..| <-- four byte "magic number"
 // |sz|sz|sz|sz| <-- four byte (native endian) size
 // |TT...TT| * (sz/sizeof(TT)) <-- enough T structures to make up sz bytes
+//
+//Chunks may instead carry an extended header, marked by a size of -1U:
+// (write_chunk uses this for compressed chunks and for chunks of 4GiB or more)
+// |ma|gi|c.|..| <-- four byte "magic number"
+// |ff|ff|ff|ff| <-- size of -1U ("extended header follows")
+// |fl|ag|s.|..| <-- four byte flags (ChunkFlag* bits)
+// |00|00|00|00| <-- four bytes reserved
+// |sz|sz|sz|sz|sz|sz|sz|sz| <-- eight byte size of chunk data (once decoded)
+// |st|st|st|st|st|st|st|st| <-- eight byte size of the data stored in the file
+// |...| * st <-- stored data
+//
+//Compressed chunks (flags & ChunkFlagCompressed) store their data as a
+// sequence of independently compressed blocks (so they can be decoded in parallel):
+// |bs|bs|bs|bs| <-- four byte decoded size of block (at most ChunkBlockSize)
+// |cs|cs|cs|cs| <-- four byte stored size of block (== bs means block is stored raw)
+// |...| * cs <-- lz4 block data (see lz4_block.hpp)
+//
+//Files may start with a table of contents chunk ('toc0') holding one
+// ChunkTocEntry per following chunk, so readers can seek straight to the
+// chunks they need (see ChunkFile.hpp); read_chunk skips over it.
 
-template< typename T >
-void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *to_) {
-	assert(to_);
-	auto &to = *to_;
+enum ChunkFlags : uint32_t {
+	ChunkFlagCompressed = 1,
+};
+
+//decoded size of each block of a compressed chunk:
+constexpr uint32_t ChunkBlockSize = 1 << 20;
+
+//entry in a 'toc0' chunk:
+struct ChunkTocEntry {
+	char magic[4] = {'\0', '\0', '\0', '\0'};
+	uint32_t flags = 0; //flags from the chunk's header
+	uint64_t offset = 0; //offset of the chunk's header from the start of the file
+	uint64_t size = 0; //size of chunk data (once decoded)
+	uint64_t stored_size = 0; //size of data stored in the file
+};
+static_assert(sizeof(ChunkTocEntry) == 4 + 4 + 8 + 8 + 8, "ChunkTocEntry is packed");
+
+//description of a chunk, read from its header:
+struct ChunkInfo {
+	std::string magic;
+	uint32_t flags = 0;
+	uint64_t size = 0; //size of chunk data (once decoded)
+	uint64_t stored_size = 0; //size of data stored in the file
+};
 
+//read the header of the next chunk in 'from':
+inline ChunkInfo read_chunk_header(std::istream &from) {
 	struct ChunkHeader {
 		char magic[4] = {'\0', '\0', '\0', '\0'};
 		uint32_t size = 0;
 	};
 	static_assert(sizeof(ChunkHeader) == 8, "header is packed");
 
+	struct ChunkExtension {
+		uint32_t flags = 0;
+		uint32_t reserved = 0;
+		uint64_t size = 0;
+		uint64_t stored_size = 0;
+	};
+	static_assert(sizeof(ChunkExtension) == 24, "extension is packed");
+
 	ChunkHeader header;
 	if (!from.read(reinterpret_cast< char * >(&header), sizeof(header))) {
 		throw std::runtime_error("Failed to read chunk header");
 	}
-	if (std::string(header.magic,4) != magic) {
-		throw std::runtime_error("Unexpected magic number in chunk");
+
+	ChunkInfo info;
+	info.magic = std::string(header.magic, 4);
+	if (header.size != -1U) {
+		info.size = info.stored_size = header.size;
+	} else {
+		ChunkExtension extension;
+		if (!from.read(reinterpret_cast< char * >(&extension), sizeof(extension))) {
+			throw std::runtime_error("Failed to read extended chunk header");
+		}
+		if (extension.flags & ~uint32_t(ChunkFlagCompressed)) {
+			throw std::runtime_error("Chunk '" + info.magic + "' uses unknown flags");
+		}
+		info.flags = extension.flags;
+		info.size = extension.size;
+		info.stored_size = extension.stored_size;
 	}
+	return info;
+}
 
-	if (header.size % sizeof(T) != 0) {
-		throw std::runtime_error("Size of chunk not divisible by element size");
+//peek at the magic number of the next chunk in 'from' without consuming anything:
+// (returns "" at end of file; useful for reading optional chunks)
+inline std::string peek_chunk_magic(std::istream &from) {
+	if (from.peek() == EOF) return "";
+	std::streampos at = from.tellg();
+	char magic[4];
+	bool got = bool(from.read(magic, 4));
+	from.clear();
+	from.seekg(at);
+	return got ? std::string(magic, 4) : std::string();
+}
+
+//decode the stored data of a chunk into 'to' (which must have room for info.size bytes):
+// (compressed blocks are decoded in parallel)
+inline void decode_chunk_data(ChunkInfo const &info, char const *stored, void *to_) {
+	char *to = reinterpret_cast< char * >(to_);
+	if (!(info.flags & ChunkFlagCompressed)) {
+		if (info.stored_size != info.size) {
+			throw std::runtime_error("Uncompressed chunk '" + info.magic + "' has mismatched sizes");
+		}
+		std::memcpy(to, stored, size_t(info.size));
+		return;
 	}
 
-	to.resize(header.size / sizeof(T));
-	if (!from.read(reinterpret_cast< char * >(&to[0]), to.size() * sizeof(T))) {
+	//locate blocks:
+	struct Block {
+		char const *src;
+		uint32_t src_size;
+		char *dst;
+		uint32_t dst_size;
+	};
+	std::vector< Block > blocks;
+	uint64_t in = 0;
+	uint64_t out = 0;
+	while (in < info.stored_size) {
+		uint32_t sizes[2];
+		if (info.stored_size - in < sizeof(sizes)) {
+			throw std::runtime_error("Truncated block header in chunk '" + info.magic + "'");
+		}
+		std::memcpy(sizes, stored + in, sizeof(sizes));
+		in += sizeof(sizes);
+		if (sizes[0] > ChunkBlockSize || sizes[1] > info.stored_size - in || sizes[0] > info.size - out) {
+			throw std::runtime_error("Block out of range in chunk '" + info.magic + "'");
+		}
+		blocks.emplace_back(Block{stored + in, sizes[1], to + out, sizes[0]});
+		in += sizes[1];
+		out += sizes[0];
+	}
+	if (out != info.size) {
+		throw std::runtime_error("Blocks of chunk '" + info.magic + "' do not cover its size");
+	}
+
+	auto decode_block = [](Block const &block) {
+		if (block.src_size == block.dst_size) {
+			std::memcpy(block.dst, block.src, block.dst_size);
+		} else {
+			lz4_block_decompress(block.src, block.src_size, block.dst, block.dst_size);
+		}
+	};
+
+	uint32_t workers = std::min< uint32_t >(uint32_t(blocks.size()), std::max(1U, std::thread::hardware_concurrency()));
+	if (workers <= 1) {
+		for (auto const &block : blocks) decode_block(block);
+		return;
+	}
+
+	//decode blocks on several threads, remembering the first error (if any):
+	std::vector< std::thread > threads;
+	std::vector< std::exception_ptr > errors(workers);
+	for (uint32_t w = 0; w < workers; ++w) {
+		threads.emplace_back([&,w](){
+			try {
+				for (size_t b = w; b < blocks.size(); b += workers) decode_block(blocks[b]);
+			} catch (...) {
+				errors[w] = std::current_exception();
+			}
+		});
+	}
+	for (auto &thread : threads) thread.join();
+	for (auto const &error : errors) {
+		if (error) std::rethrow_exception(error);
+	}
+}
+
+//compress 'size' bytes at 'data' into the block format used by compressed chunks:
+// (the inverse of decode_chunk_data)
+inline std::vector< char > encode_chunk_data(char const *data, uint64_t size) {
+	std::vector< char > stored;
+	for (uint64_t begin = 0; begin < size; begin += ChunkBlockSize) {
+		uint32_t sizes[2];
+		sizes[0] = uint32_t(std::min< uint64_t >(ChunkBlockSize, size - begin));
+		size_t at = stored.size();
+		stored.resize(at + sizeof(sizes));
+		sizes[1] = uint32_t(lz4_block_compress(data + begin, sizes[0], &stored));
+		if (sizes[1] >= sizes[0]) {
+			//incompressible; store raw:
+			stored.resize(at + sizeof(sizes));
+			stored.insert(stored.end(), data + begin, data + begin + sizes[0]);
+			sizes[1] = sizes[0];
+		}
+		std::memcpy(&stored[at], sizes, sizeof(sizes));
+	}
+	return stored;
+}
+
+//read the data of a chunk whose header was just read into 'to' (which must have room for info.size bytes):
+inline void read_chunk_data(std::istream &from, ChunkInfo const &info, void *to) {
+	if (!(info.flags & ChunkFlagCompressed)) {
+		if (info.stored_size != info.size) {
+			throw std::runtime_error("Uncompressed chunk '" + info.magic + "' has mismatched sizes");
+		}
+		if (!from.read(reinterpret_cast< char * >(to), info.size)) {
+			throw std::runtime_error("Failed to read chunk data.");
+		}
+		return;
+	}
+	std::vector< char > stored(size_t(info.stored_size));
+	if (!from.read(stored.data(), stored.size())) {
 		throw std::runtime_error("Failed to read chunk data.");
 	}
+	decode_chunk_data(info, stored.data(), to);
 }
 
+template< typename T >
+void read_chunk(std::istream &from, std::string const &magic, std::vector< T > *to_) {
+	assert(to_);
+	auto &to = *to_;
+
+	ChunkInfo info = read_chunk_header(from);
+	if (info.magic == "toc0" && magic != "toc0") {
+		//sequential readers don't need the table of contents:
+		from.seekg(std::streamoff(info.stored_size), std::ios::cur);
+		info = read_chunk_header(from);
+	}
+	if (info.magic != magic) {
+		throw std::runtime_error("Unexpected magic number in chunk");
+	}
+
+	if (info.size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+
+	to.resize(size_t(info.size / sizeof(T)));
+	read_chunk_data(from, info, to.data());
+}
+
+
+//read the data of a chunk whose header was just read, handing it to callback(T const *elements, size_t count)
+// in batches of (at most) 'batch' elements, so the whole chunk never needs to be in memory at once:
+// (compressed chunks are decoded one block at a time)
+template< typename T, typename F >
+void read_chunk_batches(std::istream &from, ChunkInfo const &info, size_t batch, F const &callback) {
+	assert(batch > 0);
+	if (info.size % sizeof(T) != 0) {
+		throw std::runtime_error("Size of chunk not divisible by element size");
+	}
+
+	std::vector< T > elements(size_t(std::min< uint64_t >(batch, info.size / sizeof(T))));
+	char *buffer = reinterpret_cast< char * >(elements.data());
+	size_t const buffer_size = elements.size() * sizeof(T);
+
+	if (!(info.flags & ChunkFlagCompressed)) {
+		if (info.stored_size != info.size) {
+			throw std::runtime_error("Uncompressed chunk '" + info.magic + "' has mismatched sizes");
+		}
+		for (uint64_t remaining = info.size; remaining > 0; ) {
+			size_t amount = size_t(std::min< uint64_t >(buffer_size, remaining));
+			if (!from.read(buffer, amount)) {
+				throw std::runtime_error("Failed to read chunk data.");
+			}
+			remaining -= amount;
+			callback(elements.data(), amount / sizeof(T));
+		}
+		return;
+	}
+
+	//decode blocks one at a time, handing off each batch as it fills:
+	std::vector< char > stored;
+	std::vector< char > decoded(ChunkBlockSize);
+	size_t filled = 0;
+	uint64_t in = 0;
+	uint64_t out = 0;
+	while (in < info.stored_size) {
+		uint32_t sizes[2];
+		if (info.stored_size - in < sizeof(sizes) || !from.read(reinterpret_cast< char * >(sizes), sizeof(sizes))) {
+			throw std::runtime_error("Truncated block header in chunk '" + info.magic + "'");
+		}
+		in += sizeof(sizes);
+		if (sizes[0] > ChunkBlockSize || sizes[1] > info.stored_size - in || sizes[0] > info.size - out) {
+			throw std::runtime_error("Block out of range in chunk '" + info.magic + "'");
+		}
+		stored.resize(sizes[1]);
+		if (!from.read(stored.data(), sizes[1])) {
+			throw std::runtime_error("Failed to read chunk data.");
+		}
+		in += sizes[1];
+		out += sizes[0];
+
+		char const *block = stored.data();
+		if (sizes[1] != sizes[0]) {
+			lz4_block_decompress(stored.data(), sizes[1], decoded.data(), sizes[0]);
+			block = decoded.data();
+		}
+		for (size_t at = 0; at < sizes[0]; ) {
+			size_t amount = std::min< size_t >(buffer_size - filled, sizes[0] - at);
+			std::memcpy(buffer + filled, block + at, amount);
+			filled += amount;
+			at += amount;
+			if (filled == buffer_size) {
+				callback(elements.data(), elements.size());
+				filled = 0;
+			}
+		}
+	}
+	if (out != info.size) {
+		throw std::runtime_error("Blocks of chunk '" + info.magic + "' do not cover its size");
+	}
+	if (filled) {
+		callback(elements.data(), filled / sizeof(T));
+	}
+}
 
 //helper function to write a chunk of data in the same format as read_chunk:
+// (pass ChunkFlagCompressed as 'flags' to store the chunk compressed)
 template< typename T >
-void write_chunk(std::string const &magic, std::vector< T > const &from, std::ostream *to_) {
+void write_chunk(std::string const &magic, std::vector< T > const &from, std::ostream *to_, uint32_t flags = 0) {
 	assert(magic.size() == 4);
 	assert(to_);
 	auto &to = *to_;
@@ -58,8 +343,44 @@ void write_chunk(std::string const &magic, std::vector< T > const &from, std::os
 	header.magic[1] = magic[1];
 	header.magic[2] = magic[2];
 	header.magic[3] = magic[3];
-	header.size = uint32_t(from.size() * sizeof(T));
+
+	struct ChunkExtension {
+		uint32_t flags = 0;
+		uint32_t reserved = 0;
+		uint64_t size = 0;
+		uint64_t stored_size = 0;
+	};
+	static_assert(sizeof(ChunkExtension) == 24, "extension is packed");
+
+	char const *data = reinterpret_cast< char const * >(from.data());
+	uint64_t size = uint64_t(from.size()) * sizeof(T);
+
+	if (!(flags & ChunkFlagCompressed)) {
+		if (size < -1U) {
+			header.size = uint32_t(size);
+			to.write(reinterpret_cast< const char * >(&header), sizeof(header));
+		} else {
+			//too big for a plain header:
+			ChunkExtension extension;
+			extension.size = extension.stored_size = size;
+			header.size = -1U;
+			to.write(reinterpret_cast< const char * >(&header), sizeof(header));
+			to.write(reinterpret_cast< const char * >(&extension), sizeof(extension));
+		}
+		to.write(data, size);
+		return;
+	}
+
+	//compress data in blocks:
+	std::vector< char > stored = encode_chunk_data(data, size);
+
+	ChunkExtension extension;
+	extension.flags = ChunkFlagCompressed;
+	extension.size = size;
+	extension.stored_size = stored.size();
+	header.size = -1U;
 
 	to.write(reinterpret_cast< const char * >(&header), sizeof(header));
-	to.write(reinterpret_cast< const char * >(from.data()), from.size() * sizeof(T));
+	to.write(reinterpret_cast< const char * >(&extension), sizeof(extension));
+	to.write(stored.data(), stored.size());
 }
@@ -15,7 +15,7 @@ for i in range(0,len(sys.argv)):
 		args = sys.argv[i+1:]
 
 if len(args) != 2:
-	print("\n\nUsage:\nblender --background --python export-meshes.py -- <infile.blend[:collection]> <outfile.pnct>\nExports the meshes referenced by all objects in the specified collection(s) (default: all objects) to a binary blob.\n")
+	print("\n\nUsage:\nblender --background --python export-meshes.py -- <infile.blend[:collection]> <outfile.pnct|outfile.pncq>\nExports the meshes referenced by all objects in the specified collection(s) (default: all objects) to a binary blob.\n'.pncq' outputs use the compact (quantized) vertex format.\n")
 	exit(1)
 
 import bpy
@@ -28,7 +28,8 @@ if m:
 	collection_name = m.group(2)
 outfile = args[1]
 
-assert outfile.endswith(".pnct")
+assert outfile.endswith(".pnct") or outfile.endswith(".pncq")
+compact = outfile.endswith(".pncq")
 
 print("Will export meshes referenced from ",end="")
 if collection_name:
@@ -97,6 +98,20 @@ strings = b''
 #index gives offsets into the data (and names) for each mesh:
 index = b''
 
+#ranges gives the quantization range for each mesh (compact format only):
+ranges = b''
+
+#bounds gives the bounding box and bounding sphere of each mesh (so the loader doesn't need to compute them):
+bounds = b''
+
+#compact format helpers:
+def pack_snorm10(x):
+	return int(round(max(-1.0, min(1.0, x)) * 511.0)) & 0x3ff
+
+def quantize(x, lo, hi):
+	if hi <= lo: return 0
+	return int(round((x - lo) / (hi - lo) * 65535.0))
+
 vertex_count = 0
 for obj in bpy.data.objects:
 	if obj.data in to_write:
@@ -159,33 +174,58 @@ for obj in bpy.data.objects:
 		if len(obj.data.uv_layers) != 1:
 			print("WARNING: object '" + name + "' has multiple texture coordinate layers; only exporting '" + obj.data.uv_layers.active.name + "'")
 
-	local_data = b''
-
-	#write the mesh triangles:
+	#gather the mesh triangles:
+	verts = []
 	for poly in mesh.polygons:
 		assert(len(poly.loop_indices) == 3)
 		for i in range(0,3):
 			assert(mesh.loops[poly.loop_indices[i]].vertex_index == poly.vertices[i])
 			loop = mesh.loops[poly.loop_indices[i]]
 			vertex = mesh.vertices[loop.vertex_index]
-			for x in vertex.co:
-				local_data += struct.pack('f', x)
-			for x in loop.normal:
-				local_data += struct.pack('f', x)
 			if colors != None:
 				col = colors[poly.loop_indices[i]].color
-				local_data += struct.pack('BBBB', int(col[0] * 255), int(col[1] * 255), int(col[2] * 255), 255)
+				col = (int(col[0] * 255), int(col[1] * 255), int(col[2] * 255), 255)
 			else:
-				local_data += struct.pack('BBBB', 255, 255, 255, 255)
+				col = (255, 255, 255, 255)
 			if uvs != None:
 				uv = uvs[poly.loop_indices[i]].uv
-				local_data += struct.pack('ff', uv.x, uv.y)
+				uv = (uv.x, uv.y)
 			else:
-				local_data += struct.pack('ff', 0, 0)
+				uv = (0, 0)
+			verts.append((tuple(vertex.co), tuple(loop.normal), col, uv))
+	vertex_count += len(mesh.polygons) * 3
+
+	lo = [min(v[0][c] for v in verts) if verts else 0.0 for c in range(0,3)]
+	hi = [max(v[0][c] for v in verts) if verts else 0.0 for c in range(0,3)]
+	if compact:
+		#quantization range is the mesh's bounding box:
+		ranges += struct.pack('fff', *lo)
+		ranges += struct.pack('fff', *hi)
+
+	#bounding sphere is centered on the bounding box:
+	center = [0.5 * (lo[c] + hi[c]) for c in range(0,3)]
+	radius = max([sum((v[0][c] - center[c]) ** 2 for c in range(0,3)) for v in verts] + [0.0]) ** 0.5
+	bounds += struct.pack('fff', *lo)
+	bounds += struct.pack('fff', *hi)
+	bounds += struct.pack('fff', *center)
+	bounds += struct.pack('f', radius)
+
+	#write the mesh triangles:
+	local_data = b''
+	for (co, normal, col, uv) in verts:
+		if compact:
+			local_data += struct.pack('HHHH', quantize(co[0], lo[0], hi[0]), quantize(co[1], lo[1], hi[1]), quantize(co[2], lo[2], hi[2]), 0)
+			local_data += struct.pack('I', pack_snorm10(normal[0]) | (pack_snorm10(normal[1]) << 10) | (pack_snorm10(normal[2]) << 20))
+			local_data += struct.pack('BBBB', *col)
+			local_data += struct.pack('ee', uv[0], uv[1])
+		else:
+			local_data += struct.pack('fff', *co)
+			local_data += struct.pack('fff', *normal)
+			local_data += struct.pack('BBBB', *col)
+			local_data += struct.pack('ff', uv[0], uv[1])
 		if len(local_data) > 1000:
 			data.append(local_data)
 			local_data = b''
-	vertex_count += len(mesh.polygons) * 3
 
 	data.append(local_data)
 
@@ -194,23 +234,34 @@ for obj in bpy.data.objects:
 data = b''.join(data)
 
 #check that code created as much data as anticipated:
-assert(vertex_count * (4*3+4*3+1*4+4*2) == len(data))
+if compact:
+	assert(vertex_count * (2*4+4+1*4+2*2) == len(data))
+else:
+	assert(vertex_count * (4*3+4*3+1*4+4*2) == len(data))
 
 #write the data chunk and index chunk to an output blob:
 blob = open(outfile, 'wb')
+def write_chunk(magic, payload):
+	blob.write(struct.pack('4s', magic)) #type
+	if len(payload) < 0xffffffff:
+		blob.write(struct.pack('I', len(payload))) #length
+	else:
+		#extended header for chunks of 4GiB or more (see read_write_chunk.hpp):
+		blob.write(struct.pack('I', 0xffffffff))
+		blob.write(struct.pack('IIQQ', 0, 0, len(payload), len(payload))) #flags, reserved, length, stored length
+	blob.write(payload)
 #first chunk: the data
-blob.write(struct.pack('4s',b'pnct')) #type
-blob.write(struct.pack('I', len(data))) #length
-blob.write(data)
+write_chunk(b'pncq' if compact else b'pnct', data)
 #second chunk: the strings
-blob.write(struct.pack('4s',b'str0')) #type
-blob.write(struct.pack('I', len(strings))) #length
-blob.write(strings)
+write_chunk(b'str0', strings)
 #third chunk: the index
-blob.write(struct.pack('4s',b'idx0')) #type
-blob.write(struct.pack('I', len(index))) #length
-blob.write(index)
+write_chunk(b'idx0', index)
+if compact:
+	#fourth chunk: the quantization ranges
+	write_chunk(b'qnt0', ranges)
+#last chunk: the bounds
+write_chunk(b'bnd0', bounds)
 wrote = blob.tell()
 blob.close()
 
-print("Wrote " + str(wrote) + " bytes [== " + str(len(data)+8) + " bytes of data + " + str(len(strings)+8) + " bytes of strings + " + str(len(index)+8) + " bytes of index] to '" + outfile + "'")
+print("Wrote " + str(wrote) + " bytes [== " + str(len(data)+8) + " bytes of data + " + str(len(strings)+8) + " bytes of strings + " + str(len(index)+8) + " bytes of index" + (" + " + str(len(ranges)+8) + " bytes of ranges" if compact else "") + " + " + str(len(bounds)+8) + " bytes of bounds] to '" + outfile + "'")
@@ -1,6 +1,10 @@
 #include "Mode.hpp"
 #include "ShowMeshesMode.hpp"
+#include "TextBenchMode.hpp"
 #include "Load.hpp"
+#include "DrawLines.hpp"
+#include "DrawSprites.hpp"
+#include "FrameArena.hpp"
 #include "GL.hpp"
 #include "load_save_png.hpp"
 
@@ -10,6 +14,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <memory>
+#include <string>
 #include <algorithm>
 
 int main(int argc, char **argv) {
@@ -81,7 +86,11 @@ int main(int argc, char **argv) {
 	//------------ create game mode + make current --------------
 	bool usage = false;
 	MeshBuffer *buffer = nullptr;
-	if (argc == 2) {
+	if (argc == 2 && std::string(argv[1]) == "--text-bench") {
+		Mode::set_current(std::make_shared< TextBenchMode >());
+		//(measure drawing, not waiting for the display)
+		SDL_GL_SetSwapInterval(0);
+	} else if (argc == 2) {
 		try {
 			buffer = new MeshBuffer(argv[1]);
 		} catch (std::exception &e) {
@@ -97,7 +106,8 @@ int main(int argc, char **argv) {
 		usage = true;
 	}
 	if (usage) {
-		std::cerr << "Usage:\n\t" << argv[0] << " [path/to/meshes.pnct]" << std::endl;
+		std::cerr << "Usage:\n\t" << argv[0] << " [path/to/meshes.pnct|.pncq]\n"
+			"\t" << argv[0] << " --text-bench    (draw 100k characters per frame and print timings)" << std::endl;
 		return 1;
 	}
 
@@ -123,6 +133,9 @@ int main(int argc, char **argv) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
+		//free last frame's transient data (see FrameArena.hpp):
+		frame_arena().reset();
+
 		{ //(1) process any events that are pending
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
@@ -172,6 +185,10 @@ int main(int argc, char **argv) {
 		{ //(3) call the current mode's "draw" function to produce output:
 		
 			Mode::current->draw(drawable_size);
+
+			//draw the lines, text, and sprites the mode drew with DrawLines and DrawSprites:
+			DrawLines::flush();
+			DrawSprites::flush();
 		}
 
 		//Wait until the recently-drawn frame is shown before doing it all again:
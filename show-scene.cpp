@@ -1,6 +1,9 @@
 #include "Mode.hpp"
 #include "ShowSceneMode.hpp"
 #include "Load.hpp"
+#include "DrawLines.hpp"
+#include "DrawSprites.hpp"
+#include "FrameArena.hpp"
 #include "GL.hpp"
 #include "load_save_png.hpp"
 #include "ShowSceneProgram.hpp"
@@ -95,7 +98,8 @@ int main(int argc, char **argv) {
 	GLuint buffer_vao = 0;
 	if (meshes_file != "") {
 		try {
-			buffer = new MeshBuffer(meshes_file);
+			//only upload the meshes the scene actually uses:
+			buffer = new MeshBuffer(meshes_file, MeshBuffer::Residency::OnLookup);
 			buffer_vao = buffer->make_vao_for_program(show_scene_program->program);
 		} catch (std::exception &e) {
 			std::cerr << "ERROR loading mesh buffer '" << meshes_file << "': " << e.what() << std::endl;
@@ -107,21 +111,16 @@ int main(int argc, char **argv) {
 	if (scene_file != "") {
 		try {
 			scene = new Scene();
-			scene->load(scene_file, [&buffer,&buffer_vao](Scene &scene, Scene::Transform *transform, std::string const &mesh_name){
-				if (!buffer_vao) return;
-				Mesh const &mesh = buffer->lookup(mesh_name);
-
-				scene.drawables.emplace_back(transform);
-				Scene::Drawable &drawable = scene.drawables.back();
-
-				drawable.pipeline = show_scene_program_pipeline;
-
-				drawable.pipeline.vao = buffer_vao;
-				drawable.pipeline.type = mesh.type;
-				drawable.pipeline.start = mesh.start;
-				drawable.pipeline.count = mesh.count;
-
-			});
+			//drawables get meshes from the mesh file (if one was given):
+			std::vector< Scene::MeshSource > sources;
+			if (buffer_vao) {
+				sources.emplace_back();
+				sources.back().file = meshes_file;
+				sources.back().buffer = buffer;
+				sources.back().pipeline = show_scene_program_pipeline;
+				sources.back().pipeline.vao = buffer_vao;
+			}
+			scene->load(scene_file, sources);
 		} catch (std::exception &e) {
 			std::cerr << "ERROR loading scene '" << scene_file << "': " << e.what() << std::endl;
 			usage = true;
@@ -138,6 +137,8 @@ int main(int argc, char **argv) {
 	std::cout << "Showing scene from '" << scene_file << "' with";
 	if (meshes_file != "") {
 		std::cout << " meshes from '" << meshes_file << "'" << std::endl;
+		MeshBuffer::ResidencyStats stats = buffer->residency_stats();
+		std::cout << "  (" << stats.resident_meshes << " of " << stats.total_meshes << " meshes resident, using " << stats.resident_bytes << " bytes; " << stats.unused_bytes << " bytes of unused meshes not uploaded)" << std::endl;
 	} else {
 		std::cout << " no meshes -- consider passing a '.pnct' file as the second argument." << std::endl;
 	}
@@ -165,6 +166,9 @@ int main(int argc, char **argv) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
+		//free last frame's transient data (see FrameArena.hpp):
+		frame_arena().reset();
+
 		{ //(1) process any events that are pending
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
@@ -214,6 +218,10 @@ int main(int argc, char **argv) {
 		{ //(3) call the current mode's "draw" function to produce output:
 		
 			Mode::current->draw(drawable_size);
+
+			//draw the lines, text, and sprites the mode drew with DrawLines and DrawSprites:
+			DrawLines::flush();
+			DrawSprites::flush();
 		}
 
 		//Wait until the recently-drawn frame is shown before doing it all again: